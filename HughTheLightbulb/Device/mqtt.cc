@@ -14,6 +14,7 @@
 #include <tick_macros.h>
 
 #include "../../third_party/display_drivers/lcd.hh"
+#include "../../third_party/mqtt_reconnect/reconnect.h"
 
 #include "mosquitto.org.h"
 
@@ -36,6 +37,9 @@ constexpr const size_t networkBufferSize    = 1024;
 constexpr const size_t incomingPublishCount = 20;
 constexpr const size_t outgoingPublishCount = 20;
 
+/// Time allowed for each attempt to connect to the broker
+constexpr uint32_t ConnectTimeoutMs = 30 * 1000;
+
 // MQTT test broker: https://test.mosquitto.org/
 // Note: port 8883 is encrypted and unautenticated
 DECLARE_AND_DEFINE_CONNECTION_CAPABILITY(MosquittoOrgMQTT,
@@ -119,20 +123,28 @@ void __cheri_compartment("hugh") hugh()
 		barrier.wait(0);
 	}
 
+	// Use the same client ID for every connection, so the broker sees
+	// one client reconnecting rather than a new one.
+	// Prefix with something recognizable, for convenience.
+	memcpy(clientID.data(), clientIDPrefix.data(), clientIDPrefix.size());
+	// Suffix with random character chain.
+	mqtt_generate_client_id(clientID.data() + clientIDPrefix.size(),
+	                        clientID.size() - clientIDPrefix.size());
+
+	// Wait a growing, random time before each reconnect, so that
+	// devices that lose their connection together don't reconnect
+	// together.
+	ReconnectBackoff backoff;
+
 	while (true)
 	{
 		status_leds()->led_off(3);
 		status_leds()->led_off(4);
 
-		// Prefix with something recognizable, for convenience.
-		memcpy(clientID.data(), clientIDPrefix.data(), clientIDPrefix.size());
-		// Suffix with random character chain.
-		mqtt_generate_client_id(clientID.data() + clientIDPrefix.size(),
-		                        clientID.size() - clientIDPrefix.size());
-
+		backoff.wait();
 		Debug::log("Connecting to MQTT broker...");
 
-		t           = UnlimitedTimeout;
+		t           = Timeout{MS_TO_TICKS(ConnectTimeoutMs)};
 		auto handle = mqtt_connect(&t,
 		                           STATIC_SEALED_VALUE(mqttTestMalloc),
 		                           CONNECTION_CAPABILITY(MosquittoOrgMQTT),
@@ -145,6 +157,7 @@ void __cheri_compartment("hugh") hugh()
 		                           outgoingPublishCount,
 		                           clientID.data(),
 		                           clientID.size());
+		t = UnlimitedTimeout;
 		status_leds()->led_on(3);
 
 		if (!Capability{handle}.is_valid())
@@ -171,6 +184,7 @@ void __cheri_compartment("hugh") hugh()
 		}
 
 		status_leds()->led_on(4);
+		backoff.connected();
 
 		while (true)
 		{
@@ -1,5 +1,6 @@
 // Copyright Configured Things Ltd and CHERIoT Contributors.
 // SPDX-License-Identifier: MIT
+#pragma once
 
 #include "cdefs.h"
 #include "compartment-macros.h"
@@ -89,6 +90,58 @@ typedef CHERI_SEALED(struct ConfigToken *) ConfigCapability;
 #define PARSER_CONFIG_CAPABILITY(name)                                         \
 	STATIC_SEALED_VALUE(__parser_config_capability_##name)
 
+/**
+ * As DEFINE_PARSER_CONFIG_CAPABILITY but with the item name given
+ * as an identifier (e.g. rgb_led rather than "rgb_led") so that it
+ * can be used from within other macros.  Use PARSER_CONFIG_CAPABILITY
+ * with the same identifier to refer to it.
+ */
+#define DEFINE_PARSER_CONFIG_CAPABILITY_ID(id, Size, UpdateInterval)           \
+                                                                               \
+	DECLARE_AND_DEFINE_STATIC_SEALED_VALUE_EXPLICIT_TYPE(                      \
+	  struct {                                                                 \
+		  size_t     size;                                                     \
+		  uint32_t   update_interval;                                          \
+		  const char Name[sizeof(#id)];                                        \
+	  },                                                                       \
+	  struct ConfigToken,                                                      \
+	  config_broker,                                                           \
+	  ParserConfigKey,                                                         \
+	  __parser_config_capability_##id,                                         \
+	  Size,                                                                    \
+	  UpdateInterval,                                                          \
+	  #id);
+
+/**
+ * As DEFINE_READ_CONFIG_CAPABILITY and DEFINE_WRITE_CONFIG_CAPABILITY
+ * but with the item name given as an identifier, for use from within
+ * other macros.  Use READ_CONFIG_CAPABILITY and WRITE_CONFIG_CAPABILITY
+ * with the same identifier to refer to them.
+ */
+#define DEFINE_READ_CONFIG_CAPABILITY_ID(id)                                   \
+                                                                               \
+	DECLARE_AND_DEFINE_STATIC_SEALED_VALUE_EXPLICIT_TYPE(                      \
+	  struct {                                                                 \
+		  const char Name[sizeof(#id)];                                        \
+	  },                                                                       \
+	  struct ConfigName,                                                       \
+	  config_broker,                                                           \
+	  ReadConfigKey,                                                           \
+	  __read_config_capability_##id,                                           \
+	  #id);
+
+#define DEFINE_WRITE_CONFIG_CAPABILITY_ID(id)                                  \
+                                                                               \
+	DECLARE_AND_DEFINE_STATIC_SEALED_VALUE_EXPLICIT_TYPE(                      \
+	  struct {                                                                 \
+		  const char Name[sizeof(#id)];                                        \
+	  },                                                                       \
+	  struct ConfigName,                                                       \
+	  config_broker,                                                           \
+	  WriteConfigKey,                                                          \
+	  __write_config_capability_##id,                                          \
+	  #id);
+
 /**
  * External view of a configuration item.
  */
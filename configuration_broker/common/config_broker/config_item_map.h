@@ -0,0 +1,198 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+
+#include "config_broker.h"
+
+/**
+ * A map for Providers from the name a config item is received
+ * under, for example the last element of an MQTT topic, to the
+ * capability to write that item.
+ *
+ * Sealed capabilities can't be used in a constant initialiser, so
+ * each entry gives a function that returns its capability, and
+ * the map is built at compile time as a perfect hash over the
+ * names.  A lookup hashes the name twice and makes one exact
+ * comparison however many items there are.
+ *
+ *   constexpr ConfigItemName Items[] = {
+ *     CONFIG_ITEM_NAME("rgb_LED", RGB_LED_CONFIG),
+ *     ...
+ *   };
+ *   constexpr ConfigItemMap ItemMap{Items};
+ *
+ *   if (auto *item = ItemMap.find(name, nameLength)) ...
+ */
+struct ConfigItemName
+{
+	std::string_view name; // Name the item is received under
+	WriteConfigCapability (*capability)();
+};
+
+/**
+ * Define a ConfigItemName for an item defined with
+ * DEFINE_WRITE_CONFIG_CAPABILITY
+ */
+#define CONFIG_ITEM_NAME(Name, Item)                                           \
+	ConfigItemName                                                             \
+	{                                                                          \
+		Name, []() -> WriteConfigCapability {                                  \
+			return WRITE_CONFIG_CAPABILITY(Item);                              \
+		}                                                                      \
+	}
+
+namespace configItemMap
+{
+	/**
+	 * Reached during constant evaluation if the map can't be
+	 * built, which makes it a compile time error.  The names must
+	 * be unique.
+	 */
+	void no_perfect_hash_for_names();
+
+	constexpr size_t power_of_two_at_least(size_t n)
+	{
+		size_t p = 1;
+		while (p < n)
+		{
+			p <<= 1;
+		}
+		return p;
+	}
+
+	constexpr uint32_t hash(std::string_view name, uint32_t seed)
+	{
+		// FNV-1a, seeded and then mixed so that every bit of the
+		// result depends on every byte of the name
+		uint32_t h = 2166136261U ^ (seed * 0x9E3779B9U);
+		for (char c : name)
+		{
+			h ^= static_cast<uint8_t>(c);
+			h *= 16777619U;
+		}
+		h ^= h >> 16;
+		h *= 0x85EBCA6BU;
+		h ^= h >> 13;
+		h *= 0xC2B2AE35U;
+		return h ^ (h >> 16);
+	}
+} // namespace configItemMap
+
+/**
+ * Hash and displace: each name is first hashed into a bucket, and
+ * each bucket has a seed, found at compile time, which hashes its
+ * names into distinct slots.
+ */
+template<size_t N>
+class ConfigItemMap
+{
+	static constexpr size_t Slots =
+	  configItemMap::power_of_two_at_least(2 * N);
+	static constexpr size_t Buckets =
+	  configItemMap::power_of_two_at_least(N / 2);
+	static constexpr uint16_t Empty = UINT16_MAX;
+
+	static_assert(N < Empty, "Too many config items");
+
+	const ConfigItemName *items;
+	uint16_t              seed[Buckets] = {};
+	uint16_t              slot[Slots]   = {};
+
+	/**
+	 * Try to place the names members[0..count) with seed s.
+	 * Leaves the slots unchanged if any of them collide.
+	 */
+	constexpr bool place(const size_t *members, size_t count, uint16_t s)
+	{
+		for (size_t j = 0; j < count; j++)
+		{
+			size_t i = members[j];
+			size_t p = configItemMap::hash(items[i].name, s) & (Slots - 1);
+			if (slot[p] != Empty)
+			{
+				while (j-- > 0)
+				{
+					slot[configItemMap::hash(items[members[j]].name, s) &
+					     (Slots - 1)] = Empty;
+				}
+				return false;
+			}
+			slot[p] = static_cast<uint16_t>(i);
+		}
+		return true;
+	}
+
+	public:
+	constexpr ConfigItemMap(const ConfigItemName (&names)[N]) : items(names)
+	{
+		// Sort the names by bucket, so that members[start[b]] to
+		// members[start[b + 1]] are the names in bucket b
+		size_t bucket[N]          = {};
+		size_t start[Buckets + 1] = {};
+		size_t members[N]         = {};
+		size_t next[Buckets]      = {};
+		size_t largest            = 0;
+
+		for (size_t i = 0; i < N; i++)
+		{
+			bucket[i] = configItemMap::hash(items[i].name, 0) & (Buckets - 1);
+			start[bucket[i] + 1]++;
+		}
+		for (size_t b = 0; b < Buckets; b++)
+		{
+			largest = std::max(largest, start[b + 1]);
+			start[b + 1] += start[b];
+			next[b]       = start[b];
+		}
+		for (size_t i = 0; i < N; i++)
+		{
+			members[next[bucket[i]]++] = i;
+		}
+
+		for (auto &s : slot)
+		{
+			s = Empty;
+		}
+
+		// Place the largest buckets first, while there is most room
+		for (size_t size = largest; size > 0; size--)
+		{
+			for (size_t b = 0; b < Buckets; b++)
+			{
+				if (start[b + 1] - start[b] != size)
+				{
+					continue;
+				}
+				uint16_t s = 1;
+				while (!place(&members[start[b]], size, s))
+				{
+					if (++s == 0)
+					{
+						configItemMap::no_perfect_hash_for_names();
+					}
+				}
+				seed[b] = s;
+			}
+		}
+	}
+
+	/**
+	 * Find the entry for a name, or nullptr if there isn't one.
+	 */
+	const ConfigItemName *find(const char *name, size_t nameLength) const
+	{
+		std::string_view key{name, nameLength};
+		uint16_t s = seed[configItemMap::hash(key, 0) & (Buckets - 1)];
+		uint16_t i = slot[configItemMap::hash(key, s) & (Slots - 1)];
+		if ((i == Empty) || (items[i].name != key))
+		{
+			return nullptr;
+		}
+		return &items[i];
+	}
+};
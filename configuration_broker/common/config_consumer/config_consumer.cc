@@ -23,14 +23,25 @@ namespace ConfigConsumer
 	 * or more configuration values and then calls the
 	 * appropriate handler.
 	 */
-	void __cheri_libcall run(ConfigItem configItems[],
-	                         size_t     numOfItems,
-	                         uint16_t   maxTimeouts)
+	void __cheri_libcall run(ConfigItem        configItems[],
+	                         size_t            numOfItems,
+	                         uint16_t          maxTimeouts,
+	                         const IdlePolicy *idlePolicy)
 	{
 		// Just for the demo keep track of the number to timeouts to give
 		// a clean exit
 		uint16_t num_timeouts = 0;
 
+		// Work out how long to wait when there are no updates. If
+		// nobody needs to know about timeouts there is no reason
+		// to wake up until something changes.
+		const IdlePolicy policy =
+		  (idlePolicy != nullptr) ? *idlePolicy : DefaultIdlePolicy;
+		const bool waitForever =
+		  (policy.timeoutMs == 0) ||
+		  ((maxTimeouts == 0) && (policy.heartbeat == nullptr));
+		uint32_t idleMs = policy.timeoutMs;
+
 		// Create the multi waiter
 		MultiWaiter mw = nullptr;
 		Timeout             t1{MS_TO_TICKS(1000)};
@@ -48,7 +59,9 @@ namespace ConfigConsumer
 		// We need to do an initial read of each item to at
 		// least get the version futex to wait on (there may not
 		// be a value yet. So set up the initial value of the
-		// events as if each item has been updated.
+		// events as if each item has been updated.  Items whose
+		// appliedVersion is still current (i.e. we're being
+		// restarted) won't be passed to the handler again.
 		for (auto i = 0; i < numOfItems; i++)
 		{
 			events[i] = {nullptr, 1};
@@ -91,6 +104,17 @@ namespace ConfigConsumer
 						continue;
 					}
 
+					// Skip items we have already applied, for example
+					// when we've been restarted after a fault in the
+					// handler for some other item.
+					if (item.version == c->appliedVersion)
+					{
+						Debug::log("Version {} of {} already applied",
+						           item.version,
+						           item.name);
+						continue;
+					}
+
 					// Make a fast claim on the data now, the handler
 					// can decide if it wants to make a full claim
 					Timeout t{5000};
@@ -115,6 +139,10 @@ namespace ConfigConsumer
 						           item.name,
 						           item.data);
 					}
+					else
+					{
+						c->appliedVersion = item.version;
+					}
 					Debug::log("After handler for {}", item.name);
 				}
 			}
@@ -128,21 +156,36 @@ namespace ConfigConsumer
 
 			// Wait for a version to change
 			Debug::log("Waiting for new events");
-			Timeout t{MS_TO_TICKS(10000)};
+			Timeout t{waitForever ? UnlimitedTimeout : MS_TO_TICKS(idleMs)};
 			if (multiwaiter_wait(&t, mw, events, numOfItems) != 0)
 			{
 				num_timeouts++;
 				Debug::log(
 				  "thread {} wait timeout {}", thread_id_get(), num_timeouts);
+
+				if (policy.heartbeat != nullptr)
+				{
+					policy.heartbeat(num_timeouts);
+				}
+
 				// For the demo exit the thread when we stop getting updates
 				if (maxTimeouts > 0 && num_timeouts >= maxTimeouts)
 				{
 					break;
 				}
+
+				// Back off the idle timeout
+				if ((policy.backoff > 1) && (idleMs < policy.maxTimeoutMs))
+				{
+					idleMs = (idleMs <= policy.maxTimeoutMs / policy.backoff)
+					           ? idleMs * policy.backoff
+					           : policy.maxTimeoutMs;
+				}
 			}
 			else
 			{
 				num_timeouts = 0;
+				idleMs       = policy.timeoutMs;
 			}
 		}
 	}
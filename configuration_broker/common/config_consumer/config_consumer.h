@@ -12,6 +12,12 @@ namespace ConfigConsumer
 
 	/**
 	 * Defines a handler for a configuration item.
+	 *
+	 * appliedVersion records the last version the handler
+	 * accepted.  As the array of items is owned by the caller
+	 * it survives a restart of run() (for example from an error
+	 * handler), so only items that have moved on since are
+	 * passed to their handler again.
 	 */
 	struct ConfigItem
 	{
@@ -19,10 +25,42 @@ namespace ConfigConsumer
 		int (*handler)(void *); // Handler to call
 		uint32_t               version;
 		std::atomic<uint32_t> *versionFutex;
+		uint32_t               appliedVersion = 0; // Last version handled
 	};
 
+	/**
+	 * Defines how long to wait when there are no updates.
+	 *
+	 * The first wait uses timeoutMs, and each consecutive timeout
+	 * multiplies it by backoff up to maxTimeoutMs.  The timeout is
+	 * reset when an update is received.  If heartbeat is set it is
+	 * called after each timeout with the number of consecutive
+	 * timeouts so far.
+	 *
+	 * A timeoutMs of 0 waits without a timeout, so an idle thread
+	 * is only woken when an item changes.
+	 */
+	struct IdlePolicy
+	{
+		uint32_t timeoutMs;    // Initial idle timeout in mS, 0 = unlimited
+		uint32_t maxTimeoutMs; // Upper limit for the idle timeout in mS
+		uint32_t backoff;      // Multiplier applied after each timeout
+		void (*heartbeat)(uint16_t timeouts); // Optional
+	};
+
+	/**
+	 * Policy used if none is given.  If maxTimeouts is also 0
+	 * then there is nothing to do on a timeout, so run() will
+	 * wait without a timeout.
+	 */
+	constexpr IdlePolicy DefaultIdlePolicy = {10000, 10000, 1, nullptr};
+
 	// Method call by a thread to wait for and process updates
-	// to configurtion items
-	void __cheri_libcall run(ConfigItem configItems[], size_t numOfItems, uint16_t maxTimeouts=0);
+	// to configurtion items.  If maxTimeouts is non zero the
+	// method returns after that many consecutive idle timeouts.
+	void __cheri_libcall run(ConfigItem        configItems[],
+	                         size_t            numOfItems,
+	                         uint16_t          maxTimeouts = 0,
+	                         const IdlePolicy *idlePolicy  = nullptr);
 
 } // namespace ConfigConsumer
\ No newline at end of file
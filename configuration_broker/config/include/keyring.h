@@ -0,0 +1,30 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Public keys of the signers of configuration messages, so that
+ * signers can be added and rotated at runtime.
+ *
+ * The key for a message is chosen by the id in its signing
+ * context.  Id 0 is the root key built into the Provider, which is
+ * the only key that can sign the keyring itself, and ids 1 to Size
+ * are key0 to key3.  A key of all zeros is not in use.
+ */
+namespace keyring
+{
+
+	const auto Size      = 4;
+	const auto KeyLength = 32;
+
+	struct Config
+	{
+		uint8_t key0[KeyLength];
+		uint8_t key1[KeyLength];
+		uint8_t key2[KeyLength];
+		uint8_t key3[KeyLength];
+	};
+
+} // namespace keyring
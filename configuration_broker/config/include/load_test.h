@@ -0,0 +1,52 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+#include <stdint.h>
+
+/**
+ * Configuration data for the load generator.  Each item carries
+ * enough for a consumer to tell how long an update took to reach it
+ * and whether it missed or repeated any updates.
+ */
+namespace loadTest
+{
+
+	/**
+	 * Number of load test items.  Each is defined by expanding
+	 * LOAD_TEST_ITEMS with a macro that takes the item name.
+	 */
+	constexpr uint16_t NumItems = 16;
+
+#define LOAD_TEST_ITEMS(X)                                                     \
+	X(load0)                                                                   \
+	X(load1)                                                                   \
+	X(load2)                                                                   \
+	X(load3)                                                                   \
+	X(load4)                                                                   \
+	X(load5)                                                                   \
+	X(load6)                                                                   \
+	X(load7)                                                                   \
+	X(load8)                                                                   \
+	X(load9)                                                                   \
+	X(load10)                                                                  \
+	X(load11)                                                                  \
+	X(load12)                                                                  \
+	X(load13)                                                                  \
+	X(load14)                                                                  \
+	X(load15)
+
+	/**
+	 * Highest value of level accepted by the parser, so that
+	 * updates with a larger level can be used as invalid ones.
+	 */
+	constexpr uint8_t MaxLevel = 100;
+
+	struct Config
+	{
+		uint32_t sequence; // Per item sequence number of the update
+		uint32_t sent;     // Low 32 bits of the cycle counter when sent
+		uint16_t item;     // Index of the item, 0 to NumItems - 1
+		uint8_t  level;    // Payload value, 0 to MaxLevel
+	};
+
+} // namespace loadTest
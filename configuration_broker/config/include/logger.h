@@ -1,7 +1,10 @@
 // Copyright Configured Things Ltd and CHERIoT Contributors.
 // SPDX-License-Identifier: MIT
 
+#include <array>
 #include <stdlib.h>
+#include <string_view>
+#include <utility>
 
 /**
  * Contrived example of configuration data for a remote
@@ -19,10 +22,23 @@ namespace logger
 		Error = 3
 	};
 
+	/**
+	 * Names of each logLevel in serialised configuration.
+	 * Parsers match these case insensitively.
+	 */
+	constexpr std::array<std::pair<std::string_view, logLevel>, 4>
+	enum_names(logLevel)
+	{
+		return {{{"Debug", logLevel::Debug},
+		         {"Info", logLevel::Info},
+		         {"Warn", logLevel::Warn},
+		         {"Error", logLevel::Error}}};
+	}
+
 	struct Host
 	{
-		char     address[16]; // ipv4 address of host
-		uint16_t port;        // port on host
+		uint32_t address; // ipv4 address of host, in host byte order
+		uint16_t port;    // port on host
 	};
 
 	struct Config
@@ -31,4 +47,15 @@ namespace logger
 		logLevel level; // required logging level
 	};
 
+	/**
+	 * The item as supplied by a Provider, with the address as a
+	 * dotted quad which the parser checks and converts.
+	 */
+	struct Source
+	{
+		char     address[16]; // ipv4 address of host as text
+		uint16_t port;        // port on host
+		logLevel level;       // required logging level
+	};
+
 }; // namespace logger
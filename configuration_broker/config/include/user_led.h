@@ -1,7 +1,10 @@
 // Copyright Configured Things Ltd and CHERIoT Contributors.
 // SPDX-License-Identifier: MIT
 
+#include <array>
 #include <stdlib.h>
+#include <string_view>
+#include <utility>
 
 /**
  * Mocked example of configuration data for a controller
@@ -17,6 +20,16 @@ namespace userLed
 		On  = 1,
 	};
 
+	/**
+	 * Names of each State in serialised configuration.
+	 * Parsers match these case insensitively.
+	 */
+	constexpr std::array<std::pair<std::string_view, State>, 2>
+	enum_names(State)
+	{
+		return {{{"Off", State::Off}, {"On", State::On}}};
+	}
+
 	struct Config
 	{
 		State led0;
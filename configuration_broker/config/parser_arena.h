@@ -0,0 +1,221 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <cheri.hh>
+#include <compartment.h>
+#include <errno.h>
+#include <locks.hh>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <thread.h>
+#include <tick_macros.h>
+
+/**
+ * Per call memory for parser sandboxes.
+ *
+ * Parsers are built with heap operations blocked, so a parse
+ * leaves nothing behind that would need heap_free_all() (which
+ * has to walk every object in the heap) to clean up.  A parser
+ * that does need dynamic memory can define PARSER_ARENA_SIZE
+ * before including parser_generator.h, in which case malloc(),
+ * free(), new and delete are served from a bump pointer arena in
+ * a static buffer.  Each allocation is bounded to its own size,
+ * free() and delete do nothing, and when the parser callback
+ * returns the whole arena is released in one step and the bytes
+ * that were used are zeroed, so nothing from one parse (including
+ * any capabilities it stored) is visible to the next.
+ *
+ * The arena is owned by one call at a time, so a parse in one
+ * thread can never see the memory of a parse in another.  A fault
+ * in a parser force unwinds out of the compartment without running
+ * destructors, so the arena also provides the compartment's error
+ * handler, which zeroes and releases the arena if the faulting
+ * thread held it.  If even that can't run (for example because the
+ * stack is exhausted) later parses fail once they time out waiting
+ * for the arena rather than blocking forever.
+ *
+ * The replacement operator new and delete are global and can't be
+ * inline, so only one translation unit in a compartment may define
+ * PARSER_ARENA_SIZE.  A parser that uses the arena must therefore
+ * be built as its own compartment rather than into the combined
+ * parsers compartment.
+ */
+template<size_t Size>
+class ParserArena
+{
+	alignas(max_align_t) uint8_t buffer[Size];
+	size_t   used  = 0;
+	int      owner = 0; // Id of the thread holding the arena, or 0
+	FlagLock lock;
+
+	/**
+	 * Zero the bytes that were used and release the arena.
+	 */
+	void release()
+	{
+		memset(buffer, 0, used);
+		used  = 0;
+		owner = 0;
+		lock.unlock();
+	}
+
+	public:
+	/**
+	 * How long to wait for a parse in another thread to finish with
+	 * the arena.
+	 */
+	static constexpr Ticks LockTimeout = MS_TO_TICKS(100);
+
+	/**
+	 * Allocate size bytes, or return nullptr if the arena is full.
+	 * The base and length are padded as needed to give a capability
+	 * with exact bounds.
+	 */
+	void *allocate(size_t size)
+	{
+		size_t length = __builtin_cheri_round_representable_length(size);
+		size_t mask   = __builtin_cheri_representable_alignment_mask(size) &
+		              ~(alignof(max_align_t) - 1);
+		size_t base =
+		  (reinterpret_cast<size_t>(buffer) + used + ~mask) & mask;
+		base -= reinterpret_cast<size_t>(buffer);
+
+		if ((size == 0) || (base > Size) || (length > Size - base))
+		{
+			return nullptr;
+		}
+		used = base + length;
+
+		CHERI::Capability p{static_cast<void *>(buffer + base)};
+		p.bounds() = length;
+		return p;
+	}
+
+	/**
+	 * Release the arena if the current thread holds it.  Called
+	 * from the compartment error handler, as a forced unwind doesn't
+	 * run the Scope destructor.
+	 */
+	void recover()
+	{
+		if (owner == thread_id_get())
+		{
+			release();
+		}
+	}
+
+	/**
+	 * Hold the arena for the duration of a parser callback, and
+	 * release everything allocated from it at the end.  Converts
+	 * to false if the arena couldn't be acquired.
+	 */
+	class Scope
+	{
+		ParserArena &arena;
+		bool         held;
+
+		public:
+		Scope(ParserArena &a) : arena(a)
+		{
+			Timeout t{LockTimeout};
+			held = arena.lock.try_lock(&t);
+			if (held)
+			{
+				arena.owner = thread_id_get();
+			}
+		}
+
+		~Scope()
+		{
+			if (held)
+			{
+				arena.release();
+			}
+		}
+
+		explicit operator bool() const
+		{
+			return held;
+		}
+	};
+};
+
+#ifdef PARSER_ARENA_SIZE
+
+#	ifndef CHERIOT_NO_AMBIENT_MALLOC
+#		error Parsers using an arena must define CHERIOT_NO_AMBIENT_MALLOC
+#	endif
+#	ifndef CHERIOT_NO_NEW_DELETE
+#		error Parsers using an arena must define CHERIOT_NO_NEW_DELETE
+#	endif
+#	ifdef COMBINED_PARSERS
+#		error Parsers using an arena must not be in the combined compartment
+#	endif
+
+namespace
+{
+	ParserArena<PARSER_ARENA_SIZE> parserArena;
+} // namespace
+
+static inline void *malloc(size_t size)
+{
+	return parserArena.allocate(size);
+}
+
+static inline void *calloc(size_t nmemb, size_t size)
+{
+	size_t total;
+	if (__builtin_mul_overflow(nmemb, size, &total))
+	{
+		return nullptr;
+	}
+	// The arena is zeroed when it is released
+	return parserArena.allocate(total);
+}
+
+static inline void free(void *) {}
+
+void *operator new(size_t size)
+{
+	return parserArena.allocate(size);
+}
+
+void *operator new[](size_t size)
+{
+	return parserArena.allocate(size);
+}
+
+void operator delete(void *) noexcept {}
+void operator delete[](void *) noexcept {}
+void operator delete(void *, size_t) noexcept {}
+void operator delete[](void *, size_t) noexcept {}
+
+/**
+ * Release the arena if a parse faults while holding it.
+ */
+enum ErrorRecoveryBehaviour
+compartment_error_handler(struct ErrorState *, size_t, size_t)
+{
+	parserArena.recover();
+	return ErrorRecoveryBehaviour::ForceUnwind;
+}
+
+/**
+ * Hold the arena for the rest of the enclosing parser callback,
+ * or fail the callback with -EBUSY if it can't be acquired.
+ */
+#	define PARSER_ARENA_SCOPE()                                               \
+		decltype(parserArena)::Scope parserArenaScope{parserArena};            \
+		if (!parserArenaScope)                                                 \
+		{                                                                      \
+			Debug::log("thread {} Parser arena busy", thread_id_get());        \
+			return -EBUSY;                                                     \
+		}
+
+#else
+
+#	define PARSER_ARENA_SCOPE()
+
+#endif
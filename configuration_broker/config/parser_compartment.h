@@ -0,0 +1,24 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+/**
+ * The compartment that hosts a parser.
+ *
+ * By default each parser is a sandbox compartment of its own, named
+ * in its DEFINE_*_CONFIG_PARSER().  Building with the
+ * combined_parsers option defines COMBINED_PARSERS and puts all of
+ * the parsers in a single "parsers" compartment instead, which
+ * saves the code, data and quota of a compartment per item at the
+ * cost of the parsers sharing a protection domain.  The parsers
+ * have no mutable state and are built with heap operations
+ * blocked, so one parse still can't affect another.  There is no
+ * per call arena in the combined compartment (parser_arena.h
+ * refuses to build there); a parser that needs dynamic memory must
+ * stay in a compartment of its own.
+ */
+#ifdef COMBINED_PARSERS
+#	define PARSER_COMPARTMENT(Name) "parsers"
+#else
+#	define PARSER_COMPARTMENT(Name) Name
+#endif
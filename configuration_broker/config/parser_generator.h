@@ -0,0 +1,500 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <cheri.hh>
+#include <compartment.h>
+#include <limits>
+#include <stddef.h>
+#include <string.h>
+#include <thread.h>
+
+#include "../common/config_broker/config_broker.h"
+#include "parser_arena.h"
+#include "parser_compartment.h"
+#include "parser_helper.h"
+
+/**
+ *
+ * Generate parsers for configuration items from a description
+ * of the fields in the item's struct.
+ *
+ * Each field is described by the name of the member, which is
+ * also used as its JSON path (so "led0.red" for the member
+ * led0.red) and a field kind from the configField namespace
+ * which defines the type and valid range of the value, for
+ * example:
+ *
+ *   constexpr JsonField Fields[] = {
+ *     JSON_CONFIG_FIELD(rgbLed::Config, led0.red, configField::Number<uint8_t>),
+ *     ...
+ *   };
+ *
+ *   DEFINE_JSON_CONFIG_PARSER(
+ *     "parser_rgb_led", rgb_led, rgbLed::Config, 1800, Fields);
+ *
+ * which defines the sealed capability to register the parser for
+ * "rgb_led", the parser callback, and the parse_rgb_led_init()
+ * entry point that registers it with the broker.
+ *
+ * The generated parser also accepts the same fields encoded as a
+ * CBOR map with text keys (see third_party/cbor_parser), which is
+ * much more compact than JSON and cheaper to parse.
+ *
+ * Items supplied as a binary struct rather than JSON use
+ * BINARY_CONFIG_FIELD and DEFINE_BINARY_CONFIG_PARSER in the same
+ * way.  Each field is range checked and copied, so the source struct
+ * must have the same layout as the config struct.  Where the values
+ * are supplied in a different form, such as an address as text,
+ * BINARY_SOURCE_FIELD and DEFINE_BINARY_SOURCE_CONFIG_PARSER name
+ * the source struct and where each value is found in it.
+ *
+ * Parsers are built with heap operations blocked.  One that needs
+ * dynamic memory defines PARSER_ARENA_SIZE first, and the generated
+ * callback then serves allocations from a per call arena (see
+ * parser_arena.h).
+ *
+ */
+
+/**
+ * Field kinds.  Each provides the JSON type, a decoder from JSON
+ * and a checked copy for binary data, specialised for the type
+ * and range of the field.
+ */
+namespace configField
+{
+
+	/**
+	 * A number in the range [Min, Max]
+	 */
+	template<typename T,
+	         T Min = std::numeric_limits<T>::min(),
+	         T Max = std::numeric_limits<T>::max()>
+	struct Number
+	{
+		static constexpr JSONTypes_t JsonType = JSONNumber;
+
+		static bool in_range(T value)
+		{
+			if ((value < Min) || (value > Max))
+			{
+				Debug::log("{} out of range", value);
+				return false;
+			}
+			return true;
+		}
+
+		static bool decode(const char *value, size_t valueLength, void *dst)
+		{
+			T result;
+			if (!decode_number<T>(value, valueLength, &result) ||
+			    !in_range(result))
+			{
+				return false;
+			}
+			*static_cast<T *>(dst) = result;
+			return true;
+		}
+
+		static bool
+		decode_integer(bool negative, uint64_t magnitude, void *dst)
+		{
+			T result;
+			if (!decode_integer_number<T>(negative, magnitude, &result) ||
+			    !in_range(result))
+			{
+				return false;
+			}
+			*static_cast<T *>(dst) = result;
+			return true;
+		}
+
+		static bool copy(const void *src, void *dst)
+		{
+			T value;
+			memcpy(&value, src, sizeof(T));
+			if (!in_range(value))
+			{
+				return false;
+			}
+			*static_cast<T *>(dst) = value;
+			return true;
+		}
+	};
+
+	/**
+	 * A fixed point number held as an integer scaled by 10^Decimals,
+	 * so with two decimals "1.5" is stored as 150.  Min and Max are
+	 * the range of the scaled value.
+	 */
+	template<typename T,
+	         unsigned Decimals,
+	         T        Min = std::numeric_limits<T>::min(),
+	         T        Max = std::numeric_limits<T>::max()>
+	struct Fixed : Number<T, Min, Max>
+	{
+		static bool decode(const char *value, size_t valueLength, void *dst)
+		{
+			T result;
+			if (!decode_fixed<T, Decimals>(value, valueLength, &result) ||
+			    !Number<T, Min, Max>::in_range(result))
+			{
+				return false;
+			}
+			*static_cast<T *>(dst) = result;
+			return true;
+		}
+
+		static bool
+		decode_integer(bool negative, uint64_t magnitude, void *dst)
+		{
+			T result;
+			if (!decode_integer_fixed<T, Decimals>(
+			      negative, magnitude, &result) ||
+			    !Number<T, Min, Max>::in_range(result))
+			{
+				return false;
+			}
+			*static_cast<T *>(dst) = result;
+			return true;
+		}
+	};
+
+	/**
+	 * An enum, given in JSON by the name of the value, or in
+	 * CBOR by either its name or value.
+	 */
+	template<typename E>
+	struct Enum
+	{
+		static constexpr JSONTypes_t JsonType = JSONString;
+
+		static bool decode(const char *value, size_t valueLength, void *dst)
+		{
+			return decode_enum<E>(value, valueLength, dst);
+		}
+
+		static bool
+		decode_integer(bool negative, uint64_t magnitude, void *dst)
+		{
+			return decode_integer_enum<E>(negative, magnitude, dst);
+		}
+
+		static bool copy(const void *src, void *dst)
+		{
+			E value;
+			memcpy(&value, src, sizeof(E));
+			if (!enumLookup::PerfectHash<E>::contains(value))
+			{
+				Debug::log("Invalid enum value {}", value);
+				return false;
+			}
+			*static_cast<E *>(dst) = value;
+			return true;
+		}
+	};
+
+	/**
+	 * A null terminated string in a char[N].  If IsValid is set
+	 * then each character must satisfy it.
+	 */
+	template<size_t N, bool (*IsValid)(char) = nullptr>
+	struct String
+	{
+		static constexpr JSONTypes_t JsonType = JSONString;
+
+		static constexpr bool (*decode_integer)(bool, uint64_t, void *) =
+		  nullptr;
+
+		static bool valid(char c)
+		{
+			if constexpr (IsValid != nullptr)
+			{
+				if (!IsValid(c))
+				{
+					Debug::log("Invalid character {}", c);
+					return false;
+				}
+			}
+			return true;
+		}
+
+		static bool decode(const char *value, size_t valueLength, void *dst)
+		{
+			for (size_t i = 0; i < valueLength; i++)
+			{
+				if (!valid(value[i]))
+				{
+					return false;
+				}
+			}
+			return decode_string<N>(value, valueLength, dst);
+		}
+
+		static bool copy(const void *src, void *dst)
+		{
+			auto *in  = static_cast<const char *>(src);
+			auto *out = static_cast<char *>(dst);
+			for (size_t i = 0; i < N; i++)
+			{
+				if (in[i] == '\0')
+				{
+					out[i] = '\0';
+					return true;
+				}
+				if (!valid(in[i]))
+				{
+					return false;
+				}
+				out[i] = in[i];
+			}
+			Debug::log("String is not terminated");
+			return false;
+		}
+	};
+
+	/**
+	 * N bytes in a uint8_t[N], given in JSON or CBOR as a string of
+	 * 2 * N hex digits, or an empty string for all zeros.
+	 */
+	template<size_t N>
+	struct Hex
+	{
+		static constexpr JSONTypes_t JsonType = JSONString;
+
+		static constexpr bool (*decode_integer)(bool, uint64_t, void *) =
+		  nullptr;
+
+		static bool decode(const char *value, size_t valueLength, void *dst)
+		{
+			return decode_hex<N>(value, valueLength, dst);
+		}
+
+		static bool copy(const void *src, void *dst)
+		{
+			memcpy(dst, src, N);
+			return true;
+		}
+	};
+
+	/**
+	 * An IPv4 address held as a uint32_t, given in JSON as a
+	 * dotted quad string, in CBOR as either a string or an integer,
+	 * and in binary as a dotted quad in a null terminated char[N].
+	 */
+	template<size_t N = 16>
+	struct IPv4Address
+	{
+		static constexpr JSONTypes_t JsonType = JSONString;
+
+		static bool decode(const char *value, size_t valueLength, void *dst)
+		{
+			return decode_ipv4(value, valueLength, dst);
+		}
+
+		static bool
+		decode_integer(bool negative, uint64_t magnitude, void *dst)
+		{
+			return decode_integer_number<uint32_t>(negative, magnitude, dst);
+		}
+
+		static bool copy(const void *src, void *dst)
+		{
+			auto  *in     = static_cast<const char *>(src);
+			size_t length = strnlen(in, N);
+			if (length == N)
+			{
+				Debug::log("String is not terminated");
+				return false;
+			}
+			return decode_ipv4(in, length, dst);
+		}
+	};
+
+} // namespace configField
+
+/**
+ * Description of a field for items supplied as a binary struct.
+ */
+struct BinaryField
+{
+	const char *name;      // Name of the member
+	size_t      srcOffset; // Offset of the value in the source
+	size_t      offset;    // Offset of the member in the struct
+	bool (*copy)(const void *src, void *dst);
+};
+
+/**
+ * Define a field from its member and kind.
+ */
+#define JSON_CONFIG_FIELD(Struct, Member, ...)                                 \
+	JsonField                                                                  \
+	{                                                                          \
+		#Member, sizeof(#Member) - 1, __VA_ARGS__::JsonType,                   \
+		  offsetof(Struct, Member), __VA_ARGS__::decode,                       \
+		  __VA_ARGS__::decode_integer                                          \
+	}
+
+#define BINARY_CONFIG_FIELD(Struct, Member, ...)                               \
+	BinaryField                                                                \
+	{                                                                          \
+		#Member, offsetof(Struct, Member), offsetof(Struct, Member),           \
+		  __VA_ARGS__::copy                                                    \
+	}
+
+/**
+ * Define a field whose value is supplied at SrcMember of a
+ * different Source struct, for example as text to be decoded.
+ */
+#define BINARY_SOURCE_FIELD(Source, SrcMember, Struct, Member, ...)            \
+	BinaryField                                                                \
+	{                                                                          \
+		#Member, offsetof(Source, SrcMember), offsetof(Struct, Member),        \
+		  __VA_ARGS__::copy                                                    \
+	}
+
+namespace
+{
+
+	/**
+	 * Parse a JSON string or CBOR map into a config struct.  A
+	 * CBOR map can be recognised from its first byte, which is
+	 * never valid at the start of a JSON document.
+	 */
+	template<size_t N>
+	inline int parse_json_config(const void *src,
+	                             void       *dst,
+	                             const JsonField (&fields)[N])
+	{
+		auto              json       = static_cast<const char *>(src);
+		CHERI::Capability jsonCap    = {src};
+		size_t            jsonLength = jsonCap.bounds();
+
+		if (cborParser::is_map(src, jsonLength))
+		{
+			bool parsed = extract_cbor_fields(
+			  static_cast<const uint8_t *>(src), jsonLength, fields, dst);
+			if (!parsed)
+			{
+				Debug::log("thread {} Invalid CBOR config ({} bytes)",
+				           thread_id_get(),
+				           jsonLength);
+			}
+			return (parsed) ? 0 : -1;
+		}
+
+		bool parsed = extract_fields(json, jsonLength, fields, dst);
+
+		if (!parsed)
+		{
+			Debug::log("thread {} Invalid config {}",
+			           thread_id_get(),
+			           std::string_view{json, jsonLength});
+		}
+
+		return (parsed) ? 0 : -1;
+	}
+
+	/**
+	 * Check and copy a binary struct of at least size bytes into
+	 * a config struct
+	 */
+	template<size_t N>
+	inline int parse_binary_config(const void *src,
+	                               void       *dst,
+	                               size_t      size,
+	                               const BinaryField (&fields)[N])
+	{
+		CHERI::Capability srcCap = {src};
+		if (srcCap.bounds() < size)
+		{
+			Debug::log("thread {} Config too short {} < {}",
+			           thread_id_get(),
+			           srcCap.bounds(),
+			           size);
+			return -1;
+		}
+
+		// Check all of the fields so that every error is reported
+		bool parsed = true;
+		for (auto &f : fields)
+		{
+			if (!f.copy(static_cast<const char *>(src) + f.srcOffset,
+			            static_cast<char *>(dst) + f.offset))
+			{
+				Debug::log("Invalid {}", f.name);
+				parsed = false;
+			}
+		}
+
+		return (parsed) ? 0 : -1;
+	}
+
+	/**
+	 * Register a parser with the Broker.
+	 */
+	inline int register_parser(ConfigCapability     cap,
+	                           __cheri_callback int parser(const void *src,
+	                                                       void       *dst),
+	                           const char          *name)
+	{
+		auto res = set_parser(cap, parser);
+		if (res < 0)
+		{
+			Debug::log("Failed to register parser for {}", name);
+		}
+		return res;
+	}
+
+} // namespace
+
+/**
+ * Define the parser capability, callback, and init entry point
+ * for a configuration item.
+ *
+ * There is no init mechanism in CHERIoT and threads are not
+ * expected to terminate, so the init entry point parse_<Id>_init()
+ * must be called (typically from a parser_init compartment) before
+ * any values can be accepted.
+ *
+ * Compartment is the name of the parser's sandbox compartment,
+ * unless the parsers are combined (see parser_compartment.h).
+ */
+#define DEFINE_JSON_CONFIG_PARSER(                                             \
+  Compartment, Id, Struct, UpdateInterval, Fields)                             \
+	DEFINE_PARSER_CONFIG_CAPABILITY_ID(Id, sizeof(Struct), UpdateInterval)     \
+                                                                               \
+	int __cheri_callback parse_##Id##_config(const void *src, void *dst)       \
+	{                                                                          \
+		PARSER_ARENA_SCOPE();                                                  \
+		return parse_json_config(src, dst, Fields);                            \
+	}                                                                          \
+                                                                               \
+	int __cheri_compartment(PARSER_COMPARTMENT(Compartment))                   \
+	  parse_##Id##_init()                                                      \
+	{                                                                          \
+		return register_parser(                                                \
+		  PARSER_CONFIG_CAPABILITY(Id), parse_##Id##_config, #Id);             \
+	}
+
+#define DEFINE_BINARY_SOURCE_CONFIG_PARSER(                                    \
+  Compartment, Id, Source, Struct, UpdateInterval, Fields)                     \
+	DEFINE_PARSER_CONFIG_CAPABILITY_ID(Id, sizeof(Struct), UpdateInterval)     \
+                                                                               \
+	int __cheri_callback parse_##Id##_config(const void *src, void *dst)       \
+	{                                                                          \
+		PARSER_ARENA_SCOPE();                                                  \
+		return parse_binary_config(src, dst, sizeof(Source), Fields);          \
+	}                                                                          \
+                                                                               \
+	int __cheri_compartment(PARSER_COMPARTMENT(Compartment))                   \
+	  parse_##Id##_init()                                                      \
+	{                                                                          \
+		return register_parser(                                                \
+		  PARSER_CONFIG_CAPABILITY(Id), parse_##Id##_config, #Id);             \
+	}
+
+#define DEFINE_BINARY_CONFIG_PARSER(                                           \
+  Compartment, Id, Struct, UpdateInterval, Fields)                             \
+	DEFINE_BINARY_SOURCE_CONFIG_PARSER(                                        \
+	  Compartment, Id, Struct, Struct, UpdateInterval, Fields)
@@ -3,10 +3,14 @@
 #pragma once
 
 #include <compartment.h>
-#include <magic_enum/magic_enum.hpp>
+#include <limits>
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
+#include <string_view>
+#include <type_traits>
 
+#include "../../third_party/cbor_parser/cbor_parser.h"
 #include "../../third_party/json_parser/json_parser.h"
 
 /**
@@ -17,111 +21,717 @@
  */
 
 /**
- * Extract a string value.
+ * Decoders which convert the value of a JSON field into
+ * the destination type, used as the decode function in a
+ * JsonField.
  */
-bool get_string(const char *json, size_t jsonLength, const char *key, char *dst)
+
+/**
+ * Decoding of JSON numbers into integer types.
+ *
+ * Digits are accumulated into a uint64_t with an exact check
+ * against the largest magnitude the destination can hold, so
+ * any value of the type is accepted and anything else rejected.
+ * Runs of eight digits are converted in one step by treating
+ * them as a vector of bytes.
+ */
+namespace numberDecoder
 {
-	char  *value;
-	size_t valueLength;
+	/**
+	 * Check if the eight bytes of v are all ASCII digits.
+	 */
+	inline bool all_digits(uint64_t v)
+	{
+		return ((v & 0xF0F0F0F0F0F0F0F0ULL) |
+		        (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >>
+		         4)) == 0x3333333333333333ULL;
+	}
+
+	/**
+	 * Convert eight ASCII digits, with the first digit in the lowest
+	 * byte, to their value.  Adjacent digits are combined into pairs,
+	 * then the pairs into fours and the fours into the result.
+	 */
+	inline uint32_t eight_digits(uint64_t v)
+	{
+		v -= 0x3030303030303030ULL;
+		v = (v * 10) + (v >> 8);
+		v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+		     (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >>
+		    32;
+		return static_cast<uint32_t>(v);
+	}
+
+	/**
+	 * Add digits from value[*i] onwards to acc, stopping at the first
+	 * character which isn't a digit or after maxDigits.  Returns false
+	 * if acc would exceed limit.
+	 */
+	inline bool accumulate(const char *value,
+	                       size_t      valueLength,
+	                       size_t     *i,
+	                       size_t      maxDigits,
+	                       uint64_t    limit,
+	                       uint64_t   *acc)
+	{
+		size_t end = valueLength;
+		if (end - *i > maxDigits)
+		{
+			end = *i + maxDigits;
+		}
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+		while (end - *i >= 8)
+		{
+			uint64_t v;
+			memcpy(&v, value + *i, sizeof(v));
+			if (!all_digits(v))
+			{
+				break;
+			}
+			if (__builtin_mul_overflow(*acc, 100000000ULL, acc) ||
+			    __builtin_add_overflow(*acc, eight_digits(v), acc) ||
+			    (*acc > limit))
+			{
+				return false;
+			}
+			*i += 8;
+		}
+#endif
+
+		for (; (*i < end) && (value[*i] >= '0') && (value[*i] <= '9'); (*i)++)
+		{
+			if (__builtin_mul_overflow(*acc, 10ULL, acc) ||
+			    __builtin_add_overflow(*acc, value[*i] - '0', acc) ||
+			    (*acc > limit))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * The largest magnitude of a value of type T with the given
+	 * sign.  The magnitude of the smallest signed value is one
+	 * larger than the largest, and only zero can be negative if
+	 * the type is unsigned.
+	 */
+	template<class T>
+	uint64_t magnitude_limit(bool negative)
+	{
+		uint64_t limit = std::numeric_limits<T>::max();
+		if (negative)
+		{
+			limit = std::is_signed_v<T> ? limit + 1 : 0;
+		}
+		return limit;
+	}
+
+	/**
+	 * Convert a sign and magnitude, which must be within
+	 * magnitude_limit(), to a value of type T.
+	 */
+	template<class T>
+	T from_magnitude(bool negative, uint64_t magnitude)
+	{
+		using Unsigned = std::make_unsigned_t<T>;
+		return negative
+		         ? static_cast<T>(Unsigned{0} - static_cast<Unsigned>(magnitude))
+		         : static_cast<T>(magnitude);
+	}
+
+	/**
+	 * Parse a JSON number as a fixed point value with the given
+	 * number of decimal places, so "1.5" with two decimals is 150.
+	 * Further decimal places are only allowed if they are zero, and
+	 * exponents are not supported.
+	 */
+	template<class T, unsigned Decimals>
+	bool parse(const char *value, size_t valueLength, T *dst)
+	{
+		static_assert(std::is_integral_v<T> && sizeof(T) <= sizeof(uint64_t),
+		              "Numbers must decode to an integer type");
+
+		size_t i        = 0;
+		bool   negative = (valueLength > 0) && (value[0] == '-');
+		if (negative)
+		{
+			i++;
+		}
+
+		uint64_t limit = magnitude_limit<T>(negative);
 
-	auto result = jsonParser::search(
-	  (char *)json, jsonLength, (char *)key, strlen(key), &value, &valueLength);
+		uint64_t acc        = 0;
+		size_t   digitStart = i;
+		if (!accumulate(value, valueLength, &i, valueLength, limit, &acc) ||
+		    (i == digitStart))
+		{
+			return false;
+		}
 
-	if (result != JSONSuccess)
+		unsigned decimals = 0;
+		if ((i < valueLength) && (value[i] == '.'))
+		{
+			i++;
+			size_t fractionStart = i;
+			if (!accumulate(value, valueLength, &i, Decimals, limit, &acc))
+			{
+				return false;
+			}
+			decimals = i - fractionStart;
+			while ((i < valueLength) && (value[i] == '0'))
+			{
+				i++;
+			}
+		}
+
+		if (i != valueLength)
+		{
+			return false;
+		}
+
+		for (; decimals < Decimals; decimals++)
+		{
+			if (__builtin_mul_overflow(acc, 10ULL, &acc) || (acc > limit))
+			{
+				return false;
+			}
+		}
+
+		*dst = from_magnitude<T>(negative, acc);
+		return true;
+	}
+
+} // namespace numberDecoder
+
+/**
+ * Decode a fixed point value, scaled by 10^Decimals, into
+ * an integer type.  The value must fit in the type exactly.
+ */
+template<class T, unsigned Decimals>
+bool decode_fixed(const char *value, size_t valueLength, void *dst)
+{
+	T result;
+	if (!numberDecoder::parse<T, Decimals>(value, valueLength, &result))
 	{
-		Debug::log("Missing key {} in {}", key, json);
+		Debug::log("{} is not a valid value for the type",
+		           std::string_view{value, valueLength});
 		return false;
 	}
 
-	strncpy(dst, value, valueLength);
-	dst[valueLength] = '\0';
+	*static_cast<T *>(dst) = result;
 	return true;
 }
 
 /**
- * Function template to extract a number value. If after
- * assignment *dst doesn't equal the value we tried to save
- * then we assume that the value has overflowed and is not
- * valid for the type.
+ * Decode an integer value.  Any value in the range of the
+ * type, including negative values for signed types, is
+ * accepted.
  */
 template<class T>
-bool get_number(const char *json, size_t jsonLength, const char *key, T *dst)
+bool decode_number(const char *value, size_t valueLength, void *dst)
 {
-	char  *value;
-	size_t valueLength;
+	return decode_fixed<T, 0>(value, valueLength, dst);
+}
 
-	auto result = jsonParser::search(
-	  (char *)json, jsonLength, (char *)key, strlen(key), &value, &valueLength);
+/**
+ * Decoders for values which are already integers, as in CBOR,
+ * given as a sign and magnitude.  A fixed point value is taken
+ * to be a whole number and scaled by 10^Decimals.
+ */
+template<class T, unsigned Decimals>
+bool decode_integer_fixed(bool negative, uint64_t magnitude, void *dst)
+{
+	uint64_t limit  = numberDecoder::magnitude_limit<T>(negative);
+	bool     inRange = (magnitude <= limit);
+	for (unsigned d = 0; inRange && (d < Decimals); d++)
+	{
+		inRange = !__builtin_mul_overflow(magnitude, 10ULL, &magnitude) &&
+		          (magnitude <= limit);
+	}
 
-	if (result != JSONSuccess)
+	if (!inRange)
 	{
-		Debug::log("Missing key {} in {}", key, json);
+		Debug::log("{}{} is not a valid value for the type",
+		           negative ? "-" : "",
+		           magnitude);
 		return false;
 	}
 
-	bool  isNumber = true;
-	int   acc      = 0;
-	char *str      = value;
-	for (int i = 0; i < valueLength && str; i++, str++)
+	*static_cast<T *>(dst) = numberDecoder::from_magnitude<T>(negative, magnitude);
+	return true;
+}
+
+template<class T>
+bool decode_integer_number(bool negative, uint64_t magnitude, void *dst)
+{
+	return decode_integer_fixed<T, 0>(negative, magnitude, dst);
+}
+
+/**
+ * Allocation free lookup of enum values by name.
+ *
+ * The names of an enum E are provided by a constexpr function
+ * enum_names(E), found by argument dependent lookup, which returns
+ * an array of name and value pairs (see include/user_led.h).
+ *
+ * At compile time we search for a seed which gives each name a
+ * different slot when hashed with case folding, so a lookup is
+ * one pass over the value to hash it and a single compare.
+ */
+namespace enumLookup
+{
+	constexpr char fold(char c)
+	{
+		return ((c >= 'A') && (c <= 'Z')) ? static_cast<char>(c + ('a' - 'A'))
+		                                  : c;
+	}
+
+	constexpr uint32_t hash(const char *s, size_t length, uint32_t seed)
 	{
-		if (isNumber && isdigit(*str))
+		uint32_t h = 2166136261U ^ seed;
+		for (size_t i = 0; i < length; i++)
 		{
-			isNumber = true;
-			acc *= 10;
-			acc += *str - 0x30;
+			h ^= static_cast<uint8_t>(fold(s[i]));
+			h *= 16777619U;
 		}
-		else
+		// The low bits only depend on the low bits of the input, so
+		// mix in the high bits as the slot is taken from the low bits.
+		return h ^ (h >> 16);
+	}
+
+	template<typename E>
+	class PerfectHash
+	{
+		static constexpr auto Names = enum_names(E{});
+
+		static_assert(Names.size() > 0 && Names.size() < 128,
+		              "Unsupported number of enum names");
+
+		// Power of two with at least twice as many slots as names
+		static constexpr size_t Slots = []() {
+			size_t slots = 1;
+			while (slots < 2 * Names.size())
+			{
+				slots *= 2;
+			}
+			return slots;
+		}();
+
+		struct Table
+		{
+			bool     found;
+			uint32_t seed;
+			uint8_t  slot[Slots]; // Index into Names + 1, or 0 if empty
+		};
+
+		static constexpr Table build()
 		{
-			isNumber = false;
+			for (uint32_t seed = 0; seed < 0x10000; seed++)
+			{
+				Table t{true, seed, {}};
+				for (size_t i = 0; t.found && (i < Names.size()); i++)
+				{
+					auto &name = Names[i].first;
+					auto  s = hash(name.data(), name.size(), seed) & (Slots - 1);
+					if (t.slot[s] != 0)
+					{
+						t.found = false;
+					}
+					t.slot[s] = static_cast<uint8_t>(i + 1);
+				}
+				if (t.found)
+				{
+					return t;
+				}
+			}
+			return Table{false, 0, {}};
 		}
+
+		static constexpr Table Lookup = build();
+
+		static_assert(Lookup.found,
+		              "No perfect hash for enum names, are any duplicated?");
+
+		public:
+		/**
+		 * Find the value with the given name, ignoring case.
+		 */
+		static bool find(const char *value, size_t valueLength, E *dst)
+		{
+			auto s =
+			  Lookup.slot[hash(value, valueLength, Lookup.seed) & (Slots - 1)];
+			if (s == 0)
+			{
+				return false;
+			}
+
+			auto &[name, e] = Names[s - 1];
+			if (name.size() != valueLength)
+			{
+				return false;
+			}
+			for (size_t i = 0; i < valueLength; i++)
+			{
+				if (fold(value[i]) != fold(name[i]))
+				{
+					return false;
+				}
+			}
+
+			*dst = e;
+			return true;
+		}
+
+		/**
+		 * Check if a value is one of the named values.
+		 */
+		static constexpr bool contains(E value)
+		{
+			for (auto &[name, e] : Names)
+			{
+				if (e == value)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+} // namespace enumLookup
+
+/**
+ * Decode an enum value based on it's string representation.
+ * The value in JSON is treated as being case insensitive.
+ */
+template<class T>
+bool decode_enum(const char *value, size_t valueLength, void *dst)
+{
+	T result;
+	if (!enumLookup::PerfectHash<T>::find(value, valueLength, &result))
+	{
+		Debug::log("Invalid emum value {}",
+		           std::string_view{value, valueLength});
+		return false;
+	}
+
+	*static_cast<T *>(dst) = result;
+	return true;
+}
+
+/**
+ * Decode an enum value given as an integer, which must be one
+ * of the named values.
+ */
+template<class T>
+bool decode_integer_enum(bool negative, uint64_t magnitude, void *dst)
+{
+	std::underlying_type_t<T> value;
+	if (!decode_integer_number<decltype(value)>(negative, magnitude, &value) ||
+	    !enumLookup::PerfectHash<T>::contains(static_cast<T>(value)))
+	{
+		Debug::log("Invalid emum value {}", magnitude);
+		return false;
 	}
 
-	if (!isNumber)
+	*static_cast<T *>(dst) = static_cast<T>(value);
+	return true;
+}
+
+/**
+ * Decode a string into a char[N], which will always be
+ * null terminated.
+ */
+template<size_t N>
+bool decode_string(const char *value, size_t valueLength, void *dst)
+{
+	if (valueLength >= N)
 	{
-		Debug::log("{} is not a number", key);
+		Debug::log("String too long {}", std::string_view{value, valueLength});
 		return false;
 	}
 
-	*dst = acc;
-	// Check we haven't lost something in the cast
-	if (*dst != acc)
+	auto *str = static_cast<char *>(dst);
+	memcpy(str, value, valueLength);
+	str[valueLength] = '\0';
+	return true;
+}
+
+/**
+ * Decode a string of 2 * N hex digits into a uint8_t[N].  An
+ * empty string sets all N bytes to zero.
+ */
+template<size_t N>
+bool decode_hex(const char *value, size_t valueLength, void *dst)
+{
+	auto *bytes = static_cast<uint8_t *>(dst);
+	if (valueLength == 0)
 	{
-		Debug::log("Value truncated {} -> {}", acc, *dst);
+		memset(bytes, 0, N);
+		return true;
+	}
+	if (valueLength != 2 * N)
+	{
+		Debug::log("Expected {} hex digits, got {}", 2 * N, valueLength);
 		return false;
 	}
 
+	for (size_t i = 0; i < 2 * N; i++)
+	{
+		char    c = value[i];
+		uint8_t digit;
+		if ((c >= '0') && (c <= '9'))
+		{
+			digit = c - '0';
+		}
+		else if ((c >= 'a') && (c <= 'f'))
+		{
+			digit = c - 'a' + 10;
+		}
+		else if ((c >= 'A') && (c <= 'F'))
+		{
+			digit = c - 'A' + 10;
+		}
+		else
+		{
+			Debug::log("Invalid hex digit {}", c);
+			return false;
+		}
+		bytes[i / 2] = (i % 2 == 0) ? (digit << 4) : (bytes[i / 2] | digit);
+	}
 	return true;
 }
 
 /**
- * Extract an enum value based on it's string representation
- * using magic enum. The value in JSON is treated as being
- * case insensitive.
+ * Decode an IPv4 address given as a dotted quad, such as
+ * "192.168.0.1", into a uint32_t in host byte order (so the
+ * first octet is the most significant byte).  Each octet must be
+ * 0 to 255 without leading zeros, and nothing else is accepted.
  */
-template<class T>
-bool get_enum(const char *json, size_t jsonLength, const char *key, T *dst)
+inline bool decode_ipv4(const char *value, size_t valueLength, void *dst)
+{
+	uint32_t address = 0;
+	size_t   i       = 0;
+
+	for (int octet = 0; octet < 4; octet++)
+	{
+		if (octet > 0)
+		{
+			if ((i >= valueLength) || (value[i] != '.'))
+			{
+				break;
+			}
+			i++;
+		}
+
+		size_t   start = i;
+		uint32_t v     = 0;
+		while ((i < valueLength) && (i - start < 3) &&
+		       (value[i] >= '0') && (value[i] <= '9'))
+		{
+			v = (v * 10) + (value[i++] - '0');
+		}
+		if ((i == start) || (v > 255) ||
+		    ((value[start] == '0') && (i - start > 1)))
+		{
+			break;
+		}
+
+		address = (address << 8) | v;
+		if ((octet == 3) && (i == valueLength))
+		{
+			*static_cast<uint32_t *>(dst) = address;
+			return true;
+		}
+	}
+
+	Debug::log("Invalid IPv4 address {}",
+	           std::string_view{value, valueLength});
+	return false;
+}
+
+/**
+ * Schema driven extraction.
+ *
+ * A parser describes the fields it needs as a table and calls
+ * extract_fields() which validates the document and finds every
+ * field in a single pass (see jsonParser::validate_and_find())
+ * before decoding them.
+ *
+ * Paths are a sequence of object keys separated by '.', for
+ * example "led0.red".  Array indexes are not supported.
+ */
+struct JsonField
+{
+	const char *path;       // Path to the value
+	size_t      pathLength; // Length of the path
+	JSONTypes_t type;       // Expected JSON type of the value
+	size_t      offset;     // Offset of the value in the destination
+	bool (*decode)(const char *value, size_t valueLength, void *dst);
+	// Decoder for an integer value in CBOR, or nullptr
+	bool (*decodeInteger)(bool negative, uint64_t magnitude, void *dst);
+};
+
+/**
+ * Helper to define a JsonField for a member of a struct
+ */
+#define JSON_FIELD(Path, JsonType, Struct, Member, Decoder)                    \
+	JsonField                                                                  \
+	{                                                                          \
+		Path, std::char_traits<char>::length(Path), JsonType,                  \
+		  offsetof(Struct, Member), Decoder, nullptr                           \
+	}
+
+/**
+ * Extract a set of fields from a JSON object into dst.  The
+ * document is validated as part of the same walk, so there is
+ * no need to call jsonParser::validate() first.
+ *
+ * The query for each field is on the stack, so this is a template
+ * on the number of fields to keep that to what the parser needs.
+ *
+ * Returns true if the document is valid and every field was found
+ * and decoded.
+ */
+template<size_t N>
+bool extract_fields(const char *json,
+                    size_t      jsonLength,
+                    const JsonField (&fields)[N],
+                    void *dst)
 {
-	char  *value;
-	size_t valueLength;
+	static_assert(N <= 32, "At most 32 fields can be extracted");
+	constexpr size_t numFields = N;
+	JSONQuery_t      queries[N];
+
+	if (jsonLength == 0)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < numFields; i++)
+	{
+		queries[i].query       = fields[i].path;
+		queries[i].queryLength = fields[i].pathLength;
+	}
+
+	if (jsonParser::validate_and_find(json, jsonLength, queries, numFields) !=
+	    JSONSuccess)
+	{
+		Debug::log("Invalid JSON");
+		return false;
+	}
+
+	for (size_t i = 0; i < numFields; i++)
+	{
+		auto &f = fields[i];
+		auto &q = queries[i];
+
+		if (q.value == nullptr)
+		{
+			Debug::log("Missing key {}", f.path);
+			return false;
+		}
+
+		if (q.jsonType != f.type)
+		{
+			Debug::log("Wrong type for {}", f.path);
+			return false;
+		}
+
+		if (!f.decode(
+		      q.value, q.valueLength, static_cast<char *>(dst) + f.offset))
+		{
+			Debug::log("Invalid value for {}", f.path);
+			return false;
+		}
+	}
+
+	return true;
+}
 
-	auto result = jsonParser::search(
-	  (char *)json, jsonLength, (char *)key, strlen(key), &value, &valueLength);
+/**
+ * Extract the same set of fields from a CBOR map into dst.
+ * Keys are text strings with the same paths as in JSON.
+ * Numbers must be CBOR integers and strings text strings,
+ * and an enum may be given either by name or by value.
+ * As with extract_fields() the queries are sized from the
+ * number of fields.
+ */
+template<size_t N>
+bool extract_cbor_fields(const uint8_t *cbor,
+                         size_t         cborLength,
+                         const JsonField (&fields)[N],
+                         void *dst)
+{
+	using cborParser::Type;
+	static_assert(N <= 32, "At most 32 fields can be extracted");
+	constexpr size_t  numFields = N;
+	cborParser::Query queries[N];
 
-	if (result != JSONSuccess)
+	if (cborLength == 0)
 	{
-		Debug::log("Missing key {} in {}", key, json);
 		return false;
 	}
 
-	std::string enum_string = std::string(value, valueLength);
-	auto        m =
-	  magic_enum::enum_cast<T>(enum_string, magic_enum::case_insensitive);
-	if (!m.has_value())
+	for (size_t i = 0; i < numFields; i++)
 	{
-		Debug::log("Invalid emum value {} for {}", enum_string, key);
+		queries[i].query       = fields[i].path;
+		queries[i].queryLength = fields[i].pathLength;
+	}
+
+	if (cborParser::validate_and_find(cbor, cborLength, queries, numFields) !=
+	    cborParser::Status::Success)
+	{
+		Debug::log("Invalid CBOR");
 		return false;
 	}
 
-	*dst = m.value();
+	for (size_t i = 0; i < numFields; i++)
+	{
+		auto &f        = fields[i];
+		auto &q        = queries[i];
+		auto *fieldDst = static_cast<char *>(dst) + f.offset;
+		bool  decoded;
+
+		if (q.type == Type::Invalid)
+		{
+			Debug::log("Missing key {}", f.path);
+			return false;
+		}
+
+		if (((q.type == Type::Unsigned) || (q.type == Type::Negative)) &&
+		    (f.decodeInteger != nullptr))
+		{
+			// A negative integer is encoded as -1 - integer
+			bool negative = (q.type == Type::Negative);
+			if (negative && (q.integer == UINT64_MAX))
+			{
+				Debug::log("Invalid value for {}", f.path);
+				return false;
+			}
+			decoded = f.decodeInteger(
+			  negative, negative ? q.integer + 1 : q.integer, fieldDst);
+		}
+		else if ((q.type == Type::Text) && (f.type == JSONString))
+		{
+			decoded = f.decode(reinterpret_cast<const char *>(q.value),
+			                   q.valueLength,
+			                   fieldDst);
+		}
+		else
+		{
+			Debug::log("Wrong type for {}", f.path);
+			return false;
+		}
+
+		if (!decoded)
+		{
+			Debug::log("Invalid value for {}", f.path);
+			return false;
+		}
+	}
+
 	return true;
 }
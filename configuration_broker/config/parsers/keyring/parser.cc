@@ -0,0 +1,59 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Code to run inside a sandbox compartment to parse the
+ * keyring of config signing keys from serialised JSON into
+ * the corresponding struct.
+ *
+ * The sealed capability, callback and init function are
+ * generated from a description of the fields in the struct
+ * by the macros in parser_generator.h
+ */
+
+/**
+ * Block heap operations
+ */
+#define CHERIOT_NO_AMBIENT_MALLOC
+#define CHERIOT_NO_NEW_DELETE
+
+#include <compartment.h>
+#include <cstdlib>
+#include <debug.hh>
+#include <string.h>
+#include <thread.h>
+
+// Expose debugging features unconditionally for this compartment.
+using Debug = ConditionalDebug<true, "Parser">;
+
+#include "config/parser_generator.h"
+
+#include "config/include/keyring.h"
+
+namespace
+{
+	using Config = keyring::Config;
+	using Key    = configField::Hex<keyring::KeyLength>;
+
+	/**
+	 * Fields to extract from the JSON, each a public key as
+	 * 64 hex digits or "" if the slot is not in use
+	 */
+	constexpr JsonField KeyringFields[] = {
+	  JSON_CONFIG_FIELD(Config, key0, Key),
+	  JSON_CONFIG_FIELD(Config, key1, Key),
+	  JSON_CONFIG_FIELD(Config, key2, Key),
+	  JSON_CONFIG_FIELD(Config, key3, Key),
+	};
+
+} // namespace
+
+/**
+ * Generate the parser for "keyring" and parse_keyring_init() to
+ * register it with the Broker.
+ */
+DEFINE_JSON_CONFIG_PARSER("parser_keyring",
+                          keyring,
+                          Config,
+                          5000,
+                          KeyringFields)
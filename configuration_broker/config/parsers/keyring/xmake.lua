@@ -0,0 +1,9 @@
+-- Copyright Configured Things Ltd and CHERIoT Contributors.
+-- SPDX-License-Identifier: MIT
+
+
+-- Parser for the signing keyring
+compartment("parser_keyring")
+    set_default(false)
+    add_includedirs("../../..")
+    add_files("parser.cc")
@@ -0,0 +1,69 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Code to run inside a sandbox compartment to parse the
+ * load test items from serialised JSON into the corresponding
+ * struct.
+ *
+ * All of the items share one struct and one description of
+ * its fields, so the sealed capability, callback and init
+ * function for each are generated by expanding LOAD_TEST_ITEMS.
+ */
+
+/**
+ * Block heap operations
+ */
+#define CHERIOT_NO_AMBIENT_MALLOC
+#define CHERIOT_NO_NEW_DELETE
+
+#include <compartment.h>
+#include <cstdlib>
+#include <debug.hh>
+#include <string.h>
+#include <thread.h>
+
+// The load generator sends invalid updates deliberately, so don't
+// report each one that fails to parse.
+using Debug = ConditionalDebug<false, "Load Test Parser">;
+
+#include "config/parser_generator.h"
+
+#include "config/include/load_test.h"
+
+#ifndef LOAD_TEST_INTERVAL_MS
+#	define LOAD_TEST_INTERVAL_MS 0
+#endif
+
+namespace
+{
+	using Config   = loadTest::Config;
+	using Sequence = configField::Number<uint32_t>;
+	using Cycles   = configField::Number<uint32_t>;
+	using Item     = configField::Number<uint16_t, 0, loadTest::NumItems - 1>;
+	using Level    = configField::Number<uint8_t, 0, loadTest::MaxLevel>;
+
+	/**
+	 * Fields to extract from the JSON
+	 */
+	constexpr JsonField LoadTestFields[] = {
+	  JSON_CONFIG_FIELD(Config, sequence, Sequence),
+	  JSON_CONFIG_FIELD(Config, sent, Cycles),
+	  JSON_CONFIG_FIELD(Config, item, Item),
+	  JSON_CONFIG_FIELD(Config, level, Level),
+	};
+
+} // namespace
+
+/**
+ * Generate the parser for each load test item and the matching
+ * parse_<item>_init() to register it with the Broker.
+ */
+#define LOAD_TEST_PARSER(Id)                                                   \
+	DEFINE_JSON_CONFIG_PARSER("parser_load_test",                              \
+	                          Id,                                              \
+	                          Config,                                          \
+	                          LOAD_TEST_INTERVAL_MS,                           \
+	                          LoadTestFields)
+
+LOAD_TEST_ITEMS(LOAD_TEST_PARSER)
@@ -0,0 +1,18 @@
+-- Copyright Configured Things Ltd and CHERIoT Contributors.
+-- SPDX-License-Identifier: MIT
+
+
+option("load-interval")
+    set_default("0")
+    set_description("Minimum interval in mS between updates to each load test item, 0 for no limit")
+
+-- Parser for the load test items
+compartment("parser_load_test")
+    set_default(false)
+    add_includedirs("../../..")
+    add_files("parser.cc")
+
+    on_load(function(target)
+        target:add('options', "load-interval")
+        target:add("defines", "LOAD_TEST_INTERVAL_MS=" .. tostring(get_config("load-interval")))
+    end)
@@ -28,6 +28,7 @@ using Debug = ConditionalDebug<true, "System Config Parser">;
 
 // Set for Items we are allowed to register a parser for
 #include "common/config_broker/config_broker.h"
+#include "config/parser_compartment.h"
 
 #include "config/include/system_config.h"
 #define SYSTEM_CONFIG "system"
@@ -95,7 +96,8 @@ int __cheri_callback parse_system_config(const void *src, void *dst)
  * just to run this which then blocks we expose it as method for
  * the Broker to call when the first item is published.
  */
-int __cheri_compartment("parser_system_config") parse_system_config_init()
+int __cheri_compartment(PARSER_COMPARTMENT("parser_system_config"))
+  parse_system_config_init()
 {
 	auto res =
 	  set_parser(PARSER_CONFIG_CAPABILITY(SYSTEM_CONFIG), parse_system_config);
@@ -0,0 +1,169 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+// Tests for the per call parser arena (config/parser_arena.h).
+// This is the one translation unit in the binary that defines
+// PARSER_ARENA_SIZE, as in a parser compartment, so malloc() and
+// new here are served from the arena.  It mustn't include
+// stdlib.h, whose malloc() would clash with the arena's.
+
+#define CHERIOT_NO_AMBIENT_MALLOC
+#define CHERIOT_NO_NEW_DELETE
+#define PARSER_ARENA_SIZE 64
+
+#include <debug.hh>
+#include <new>
+#include <stdio.h>
+
+using Debug = ConditionalDebug<false, "Arena Test">;
+
+#include "config/parser_arena.h"
+
+namespace
+{
+	int failures = 0;
+
+	void check(bool ok, const char *what)
+	{
+		if (!ok)
+		{
+			printf("FAIL: %s\n", what);
+			failures++;
+		}
+	}
+
+	bool is_aligned(const void *p)
+	{
+		return (reinterpret_cast<size_t>(p) % alignof(max_align_t)) == 0;
+	}
+
+	bool is_zero(const void *p, size_t length)
+	{
+		auto *bytes = static_cast<const uint8_t *>(p);
+		for (size_t i = 0; i < length; i++)
+		{
+			if (bytes[i] != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void *firstAllocation;
+
+	/**
+	 * Stand in for a parser callback, which allocates in the same
+	 * ways a parser might and leaves it all for the arena to free.
+	 */
+	int parse()
+	{
+		PARSER_ARENA_SCOPE();
+
+		auto *text   = static_cast<char *>(malloc(10));
+		auto *values = static_cast<uint32_t *>(calloc(2, sizeof(uint32_t)));
+		auto *value  = new uint64_t{42};
+		if ((text == nullptr) || (values == nullptr) || (value == nullptr))
+		{
+			return -1;
+		}
+		firstAllocation = text;
+
+		bool ok = is_aligned(text) && is_aligned(values) && is_aligned(value) &&
+		          is_zero(values, 2 * sizeof(uint32_t)) && (*value == 42);
+		memset(text, 0xAA, 10);
+		values[1] = 0x55555555;
+		free(text);
+		delete value;
+		return ok ? 0 : -1;
+	}
+
+	/**
+	 * Stand in for a parser callback which faults after allocating.
+	 * A forced unwind doesn't run destructors, so the scope is built
+	 * in place and never destroyed.
+	 */
+	void parse_and_fault()
+	{
+		alignas(decltype(parserArena)::Scope) uint8_t
+		  scopeBuffer[sizeof(decltype(parserArena)::Scope)];
+		new (scopeBuffer) decltype(parserArena)::Scope{parserArena};
+		memset(malloc(PARSER_ARENA_SIZE), 0xAA, PARSER_ARENA_SIZE);
+	}
+
+} // namespace
+
+int main()
+{
+	{
+		ParserArena<128> arena;
+		void            *first;
+		{
+			decltype(arena)::Scope scope{arena};
+			check(arena.allocate(0) == nullptr, "empty allocation");
+
+			first   = arena.allocate(10);
+			auto *b = static_cast<uint8_t *>(arena.allocate(10));
+			check((first != nullptr) && (b != nullptr), "allocations");
+			check(is_aligned(first) && is_aligned(b), "alignment");
+			check(b >= static_cast<uint8_t *>(first) + 10, "overlap");
+			memset(first, 0xAA, 10);
+			memset(b, 0x55, 10);
+
+			check(arena.allocate(128) == nullptr, "allocation past the end");
+			check(arena.allocate(SIZE_MAX) == nullptr, "huge allocation");
+		}
+
+		// Everything is released and zeroed at the end of the scope
+		{
+			decltype(arena)::Scope scope{arena};
+			void *p = arena.allocate(128);
+			check(p == first, "arena released");
+			check((p != nullptr) && is_zero(p, 128), "arena zeroed");
+		}
+	}
+
+	{
+		// The arena only has room for one parse's allocations, so
+		// every parse must release them.
+		bool parsed = true;
+		void *first = nullptr;
+		for (int i = 0; i < 100; i++)
+		{
+			parsed = parsed && (parse() == 0);
+			if (i == 0)
+			{
+				first = firstAllocation;
+			}
+			parsed = parsed && (firstAllocation == first);
+		}
+		check(parsed, "repeated parses");
+
+		// Nothing is left from the last parse
+		PARSER_ARENA_SCOPE();
+		void *p = malloc(PARSER_ARENA_SIZE);
+		check((p != nullptr) && is_zero(p, PARSER_ARENA_SIZE),
+		      "arena zeroed after parse");
+		check(malloc(1) == nullptr, "arena full");
+		check(calloc(SIZE_MAX / 2, 4) == nullptr, "calloc overflow");
+	}
+
+	{
+		// A parse that faults leaves the arena held until the error
+		// handler releases it.
+		parse_and_fault();
+		check(parse() == -EBUSY, "arena held after a fault");
+		check(compartment_error_handler(nullptr, 0, 0) ==
+		        ErrorRecoveryBehaviour::ForceUnwind,
+		      "error handler unwinds");
+		check(parse() == 0, "arena released after a fault");
+
+		PARSER_ARENA_SCOPE();
+		void *p = malloc(PARSER_ARENA_SIZE);
+		check((p != nullptr) && is_zero(p, PARSER_ARENA_SIZE),
+		      "arena zeroed after a fault");
+	}
+
+	printf("%d failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,42 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+// libFuzzer entry point for one parser, selected at build time with
+// FUZZ_PARSER.  Each input is copied into a buffer of exactly its
+// own length, as the broker does, so that any read beyond the
+// bounds a parser is given is caught by the address sanitizer.
+
+#include <cheri.hh>
+#include <stdlib.h>
+
+#include "parsers.h"
+
+#ifndef FUZZ_PARSER
+#	error FUZZ_PARSER must name the parser to fuzz
+#endif
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	static const hostParsers::Parser *parser = hostParsers::find(FUZZ_PARSER);
+	if (parser == nullptr)
+	{
+		abort();
+	}
+
+	if (size == 0)
+	{
+		// The broker never passes an empty value
+		return 0;
+	}
+
+	auto *src = static_cast<uint8_t *>(malloc(size));
+	auto *dst = malloc(parser->configSize);
+	memcpy(src, data, size);
+
+	hostShim::set_bounds(src, size);
+	parser->parse(src, dst);
+
+	free(dst);
+	free(src);
+	return 0;
+}
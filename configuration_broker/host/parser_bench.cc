@@ -0,0 +1,128 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+// Throughput benchmark for the config parsers.
+//
+// Usage: parser_bench [corpus directory] [iterations]
+//
+// Each file in <corpus>/<parser name>/ is one message for that
+// parser.  Every message is parsed the given number of times and
+// the throughput is reported for each parser, along with how many
+// of the messages were accepted so that a change in behaviour is
+// as visible as a change in speed.
+
+#include <algorithm>
+#include <chrono>
+#include <cheri.hh>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "parsers.h"
+
+namespace
+{
+
+	/**
+	 * A message held in a buffer of exactly its own length.
+	 */
+	struct Message
+	{
+		std::vector<uint8_t> data;
+	};
+
+	std::vector<Message> load_corpus(const std::filesystem::path &dir)
+	{
+		std::vector<Message> messages;
+		if (!std::filesystem::is_directory(dir))
+		{
+			return messages;
+		}
+
+		std::vector<std::filesystem::path> files;
+		for (auto &entry : std::filesystem::directory_iterator(dir))
+		{
+			if (entry.is_regular_file())
+			{
+				files.push_back(entry.path());
+			}
+		}
+		std::sort(files.begin(), files.end());
+
+		for (auto &file : files)
+		{
+			std::ifstream in(file, std::ios::binary);
+			Message       m;
+			m.data.assign(std::istreambuf_iterator<char>(in),
+			              std::istreambuf_iterator<char>());
+			if (!m.data.empty())
+			{
+				m.data.shrink_to_fit();
+				messages.push_back(std::move(m));
+			}
+		}
+		return messages;
+	}
+
+	void run(const hostParsers::Parser     &parser,
+	         const std::vector<Message> &messages,
+	         unsigned                    iterations)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		std::vector<uint8_t> dst(parser.configSize);
+		size_t               bytes    = 0;
+		size_t               accepted = 0;
+
+		for (auto &m : messages)
+		{
+			bytes += m.data.size();
+			hostShim::set_bounds(m.data.data(), m.data.size());
+			accepted += (parser.parse(m.data.data(), dst.data()) == 0);
+		}
+
+		auto start = Clock::now();
+		for (unsigned i = 0; i < iterations; i++)
+		{
+			for (auto &m : messages)
+			{
+				hostShim::set_bounds(m.data.data(), m.data.size());
+				parser.parse(m.data.data(), dst.data());
+			}
+		}
+		std::chrono::duration<double> elapsed = Clock::now() - start;
+
+		double count   = static_cast<double>(messages.size()) * iterations;
+		double seconds = elapsed.count();
+		printf("%-10s %5zu msgs %5zu ok %8.1f MB/s %9.1f ns/msg\n",
+		       parser.name,
+		       messages.size(),
+		       accepted,
+		       (static_cast<double>(bytes) * iterations) / seconds / 1e6,
+		       seconds * 1e9 / count);
+	}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	std::filesystem::path corpus     = (argc > 1) ? argv[1] : "corpus";
+	unsigned              iterations = (argc > 2) ? atoi(argv[2]) : 10000;
+
+	for (auto &parser : hostParsers::Parsers)
+	{
+		auto messages = load_corpus(corpus / parser.name);
+		if (messages.empty())
+		{
+			printf("%-10s no messages in %s\n",
+			       parser.name,
+			       (corpus / parser.name).c_str());
+			continue;
+		}
+		run(parser, messages, iterations);
+	}
+	return 0;
+}
@@ -0,0 +1,51 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// The parsers built for the host, each compiled unchanged from
+// config/parsers/<name>/parser.cc.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config/include/keyring.h"
+#include "config/include/logger.h"
+#include "config/include/rgb_led.h"
+#include "config/include/user_led.h"
+
+int parse_rgb_led_config(const void *src, void *dst);
+int parse_user_led_config(const void *src, void *dst);
+int parse_logger_config(const void *src, void *dst);
+int parse_keyring_config(const void *src, void *dst);
+
+namespace hostParsers
+{
+
+	struct Parser
+	{
+		const char *name;       // Name of the config item
+		int (*parse)(const void *src, void *dst);
+		size_t      configSize; // Size of the config struct
+	};
+
+	constexpr Parser Parsers[] = {
+	  {"rgb_led", parse_rgb_led_config, sizeof(rgbLed::Config)},
+	  {"user_led", parse_user_led_config, sizeof(userLed::Config)},
+	  {"logger", parse_logger_config, sizeof(logger::Config)},
+	  {"keyring", parse_keyring_config, sizeof(keyring::Config)},
+	};
+
+	inline const Parser *find(const char *name)
+	{
+		for (auto &p : Parsers)
+		{
+			if (strcmp(p.name, name) == 0)
+			{
+				return &p;
+			}
+		}
+		return nullptr;
+	}
+
+} // namespace hostParsers
@@ -0,0 +1,110 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+// Tests for the replay protection the Sonata provider applies to
+// signed config messages (sonata/provider/replay.h).
+
+#include <stdio.h>
+
+#include "sonata/provider/replay.h"
+
+namespace
+{
+	int failures = 0;
+
+	void check(bool ok, const char *what)
+	{
+		if (!ok)
+		{
+			printf("FAIL: %s\n", what);
+			failures++;
+		}
+	}
+
+	/**
+	 * Check and record a message as the provider does, returning
+	 * true if it would be applied.  A message the Broker doesn't
+	 * accept isn't recorded.
+	 */
+	template<size_t N>
+	bool apply(ReplayGuard<N>   &guard,
+	           uint8_t           keyId,
+	           std::string_view  item,
+	           uint32_t          counter,
+	           bool              accepted = true)
+	{
+		if (!guard.can_track(item) || guard.is_replay(keyId, item, counter))
+		{
+			return false;
+		}
+		if (accepted)
+		{
+			guard.record(keyId, item, counter);
+		}
+		return true;
+	}
+
+} // namespace
+
+int main()
+{
+	{
+		// Retained items signed by one key, with counters far apart
+		// and delivered newest first, are all applied.
+		ReplayGuard<5> guard;
+		check(apply(guard, 0, "user_LED", 500), "first retained item");
+		check(apply(guard, 0, "rgb_LED", 100), "older retained item");
+		check(apply(guard, 0, "keyring", 3), "much older retained item");
+
+		// Redelivering them on a reconnect is a replay
+		check(!apply(guard, 0, "user_LED", 500), "redelivered item");
+		check(!apply(guard, 0, "rgb_LED", 100), "redelivered older item");
+		check(!apply(guard, 0, "rgb_LED", 99), "older message for an item");
+
+		// Newer messages are applied
+		check(apply(guard, 0, "rgb_LED", 501), "newer message");
+		check(!apply(guard, 0, "rgb_LED", 501), "newer message again");
+
+		// A message the Broker rejected, for example because of its
+		// rate limit, is applied when it is delivered again
+		check(apply(guard, 0, "rgb_LED", 502, false), "rejected message");
+		check(apply(guard, 0, "rgb_LED", 502), "rejected message again");
+		check(!apply(guard, 0, "rgb_LED", 502), "applied message again");
+	}
+
+	{
+		// Each key has its own counters for the same item
+		ReplayGuard<5> guard;
+		check(apply(guard, 1, "rgb_LED", 50), "key 1");
+		check(apply(guard, 2, "rgb_LED", 10), "key 2 below key 1");
+		check(!apply(guard, 2, "rgb_LED", 10), "key 2 replay");
+
+		// A replaced key starts again
+		guard.forget_key(1);
+		check(apply(guard, 1, "rgb_LED", 1), "replaced key");
+		check(!apply(guard, 2, "rgb_LED", 10), "other key unchanged");
+	}
+
+	{
+		// Items beyond the table size can't be tracked, so they
+		// are rejected rather than applied without protection
+		ReplayGuard<1> guard;
+		char           names[9][16];
+		for (int i = 0; i < 9; i++)
+		{
+			snprintf(names[i], sizeof(names[i]), "item%d", i);
+		}
+		for (int i = 0; i < 8; i++)
+		{
+			check(apply(guard, 0, names[i], 1), "item within table");
+		}
+		check(!apply(guard, 0, names[8], 1), "item beyond table");
+		check(apply(guard, 0, names[0], 2), "tracked item still applied");
+		check(!guard.can_track(""), "empty name");
+		check(!guard.can_track("a_name_that_is_far_too_long_to_keep"),
+		      "long name");
+	}
+
+	printf("replay_test: %s\n", failures == 0 ? "passed" : "FAILED");
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// Host shim for the CHERIoT SDK cdefs.h.  Compartment attributes
+// have no meaning on the host.
+
+#define __cheri_libcall
+#define __cheri_callback
+#define __cheri_compartment(x)
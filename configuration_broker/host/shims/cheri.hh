@@ -0,0 +1,67 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// Host shim for CHERI::Capability.  Host pointers carry no bounds,
+// so the harness records the length of each buffer it passes to a
+// parser with hostShim::set_bounds().
+
+#include <stddef.h>
+
+// Every length and alignment is representable on the host
+#define __builtin_cheri_round_representable_length(length) (length)
+#define __builtin_cheri_representable_alignment_mask(length) (~size_t(0))
+
+namespace hostShim
+{
+	/**
+	 * Record the bounds of a buffer.  Only the most recent buffer
+	 * is remembered, which is enough for one parse at a time.
+	 */
+	void set_bounds(const void *base, size_t length);
+
+	size_t bounds(const void *base);
+} // namespace hostShim
+
+namespace CHERI
+{
+	template<typename T = void>
+	class Capability
+	{
+		const T *pointer;
+
+		public:
+		Capability(const T *p) : pointer(p) {}
+
+		/**
+		 * Bounds can be read, and setting them has no effect.
+		 */
+		class Bounds
+		{
+			const T *pointer;
+
+			public:
+			Bounds(const T *p) : pointer(p) {}
+
+			operator size_t() const
+			{
+				return hostShim::bounds(pointer);
+			}
+
+			Bounds &operator=(size_t)
+			{
+				return *this;
+			}
+		};
+
+		Bounds bounds() const
+		{
+			return {pointer};
+		}
+
+		operator T *() const
+		{
+			return const_cast<T *>(pointer);
+		}
+	};
+} // namespace CHERI
@@ -0,0 +1,5 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// Host shim for the CHERIoT SDK compartment-macros.h
@@ -0,0 +1,44 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// Host shim for the CHERIoT SDK compartment.h.  Sealed values
+// become plain statics and the heap API reports an unlimited quota.
+
+#include <cdefs.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define CHERI_SEALED(T) T
+
+#define DECLARE_AND_DEFINE_STATIC_SEALED_VALUE_EXPLICIT_TYPE(                  \
+  type, sealedType, compartment, keyName, name, ...)                           \
+	static type        name##_value = {__VA_ARGS__};                           \
+	static sealedType *name = reinterpret_cast<sealedType *>(&name##_value);
+
+#define STATIC_SEALED_VALUE(name) (name)
+
+#define MALLOC_CAPABILITY nullptr
+
+static inline ssize_t heap_quota_remaining(void *)
+{
+	return SSIZE_MAX;
+}
+
+static inline int heap_free_all(void *)
+{
+	return 0;
+}
+
+struct ErrorState;
+
+enum ErrorRecoveryBehaviour
+{
+	InstallContext,
+	ForceUnwind,
+};
+
+extern "C" enum ErrorRecoveryBehaviour
+compartment_error_handler(struct ErrorState *frame, size_t mcause, size_t mtval);
@@ -0,0 +1,42 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// Host shim for the CHERIoT debug.hh.  Messages are only printed
+// (without their arguments) when PARSER_HOST_DEBUG is set in the
+// environment, so that the benchmark measures the parsers rather
+// than stderr.
+
+#include <stddef.h>
+
+namespace hostShim
+{
+	void log(const char *context, const char *format);
+} // namespace hostShim
+
+template<size_t N>
+struct DebugContext
+{
+	char name[N];
+
+	constexpr DebugContext(const char (&s)[N])
+	{
+		for (size_t i = 0; i < N; i++)
+		{
+			name[i] = s[i];
+		}
+	}
+};
+
+template<bool Enabled, DebugContext Context>
+struct ConditionalDebug
+{
+	template<typename... Args>
+	static void log(const char *format, Args &&...)
+	{
+		if constexpr (Enabled)
+		{
+			hostShim::log(Context.name, format);
+		}
+	}
+};
@@ -0,0 +1,48 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+#include <cheri.hh>
+#include <compartment.h>
+#include <debug.hh>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common/config_broker/config_broker.h"
+
+namespace
+{
+	const void *boundsBase;
+	size_t      boundsLength;
+} // namespace
+
+namespace hostShim
+{
+	void set_bounds(const void *base, size_t length)
+	{
+		boundsBase   = base;
+		boundsLength = length;
+	}
+
+	size_t bounds(const void *base)
+	{
+		return (base == boundsBase) ? boundsLength : 0;
+	}
+
+	void log(const char *context, const char *format)
+	{
+		static const bool Enabled = getenv("PARSER_HOST_DEBUG") != nullptr;
+		if (Enabled)
+		{
+			fprintf(stderr, "%s: %s\n", context, format);
+		}
+	}
+} // namespace hostShim
+
+/**
+ * The parsers are called directly, so registration always succeeds.
+ */
+int set_parser(ConfigCapability,
+               __cheri_callback int (*)(const void *src, void *dst))
+{
+	return 0;
+}
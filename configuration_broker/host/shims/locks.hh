@@ -0,0 +1,43 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// Host shim for the CHERIoT SDK locks.hh.  The harness is single
+// threaded, so a lock that is held can only be waited for until
+// the timeout expires, and lock() only needs to catch recursive use.
+// This doesn't include stdlib.h, as a test of parser_arena.h defines
+// its own malloc().
+
+#include <timeout.h>
+
+class FlagLock
+{
+	bool held = false;
+
+	public:
+	bool try_lock(Timeout *timeout)
+	{
+		if (held)
+		{
+			timeout->elapsed += timeout->remaining;
+			timeout->remaining = 0;
+			return false;
+		}
+		held = true;
+		return true;
+	}
+
+	void lock()
+	{
+		if (held)
+		{
+			__builtin_trap();
+		}
+		held = true;
+	}
+
+	void unlock()
+	{
+		held = false;
+	}
+};
@@ -0,0 +1,10 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// Host shim for the CHERIoT SDK thread.h
+
+static inline int thread_id_get()
+{
+	return 1;
+}
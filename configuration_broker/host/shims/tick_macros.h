@@ -0,0 +1,8 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// Host shim for the CHERIoT SDK tick_macros.h, with the Sonata
+// tick rate.
+
+#define MS_TO_TICKS(x) ((x) / 10)
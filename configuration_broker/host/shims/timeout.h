@@ -0,0 +1,17 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// Host shim for the CHERIoT SDK timeout.h
+
+#include <stdint.h>
+
+typedef uint32_t Ticks;
+
+struct Timeout
+{
+	Ticks elapsed   = 0;
+	Ticks remaining = 0;
+
+	Timeout(Ticks time) : remaining(time) {}
+};
@@ -0,0 +1,84 @@
+-- Copyright Configured Things Ltd and CHERIoT Contributors.
+-- SPDX-License-Identifier: MIT
+
+-- Host build of the config parsers, so that their performance and
+-- robustness can be checked on an ordinary Linux machine without a
+-- board or simulator.  The parsers are compiled unchanged against
+-- the shims in shims/, with clang since the broker's headers use
+-- clang extensions.
+--
+--   xmake f -P . && xmake -P .
+--   xmake run -P . parser_bench $(pwd)/corpus
+--
+-- Unit tests for code shared with the firmware are run with
+--
+--   xmake test -P .
+--
+-- With --fuzz=y a libFuzzer target fuzz_<parser> is
+-- built for each parser, for example
+--
+--   xmake f -P . --fuzz=y && xmake -P .
+--   xmake run -P . fuzz_rgb_led $(pwd)/corpus/rgb_led
+
+set_project("Config parser host harness")
+set_languages("c++20")
+add_rules("mode.release", "mode.debug")
+set_toolchains("clang")
+
+option("fuzz")
+    set_default(false)
+    set_description("Build libFuzzer targets for the parsers")
+
+if has_config("fuzz") then
+    add_cxflags("-fsanitize=fuzzer-no-link,address,undefined")
+    add_ldflags("-fsanitize=address,undefined")
+end
+
+-- Parsers and the libraries they use
+target("parser_host")
+    set_kind("static")
+    add_includedirs("shims", "..", {public = true})
+    add_forceincludes("cdefs.h", {public = true})
+    add_files("shims/host_shims.cc")
+    add_files("../../third_party/json_parser/json_parser.cc")
+    add_files("../../third_party/json_parser/coreJSON/core_json.cc")
+    add_files("../../third_party/cbor_parser/cbor_parser.cc")
+    add_files("../config/parsers/rgb_led/parser.cc")
+    add_files("../config/parsers/user_led/parser.cc")
+    add_files("../config/parsers/logger/parser.cc")
+    add_files("../config/parsers/keyring/parser.cc")
+
+-- Corpus driven throughput benchmark
+target("parser_bench")
+    set_kind("binary")
+    add_deps("parser_host")
+    add_files("parser_bench.cc")
+
+-- Replay protection for signed config messages
+target("replay_test")
+    set_kind("binary")
+    set_default(false)
+    add_includedirs("..")
+    add_files("replay_test.cc")
+    add_tests("default")
+
+-- Per call parser arena
+target("arena_test")
+    set_kind("binary")
+    set_default(false)
+    add_includedirs("shims", "..")
+    add_forceincludes("cdefs.h")
+    add_files("arena_test.cc")
+    add_tests("default")
+
+-- libFuzzer entry point for each parser
+if has_config("fuzz") then
+    for _, name in ipairs({"rgb_led", "user_led", "logger", "keyring"}) do
+        target("fuzz_" .. name)
+            set_kind("binary")
+            add_deps("parser_host")
+            add_files("fuzz_parser.cc")
+            add_defines("FUZZ_PARSER=\"" .. name .. "\"")
+            add_ldflags("-fsanitize=fuzzer")
+    end
+end
@@ -50,9 +50,13 @@ namespace
 		logger         = static_cast<logger::Config *>(newConfig);
 
 		// Process the configuration change
-		Debug::log("Configured with host: {} port: {} level: {}",
-		           (const char *)logger->host.address,
-		           (int16_t)logger->host.port,
+		auto address = logger->host.address;
+		Debug::log("Configured with host: {}.{}.{}.{} port: {} level: {}",
+		           (address >> 24) & 0xff,
+		           (address >> 16) & 0xff,
+		           (address >> 8) & 0xff,
+		           address & 0xff,
+		           logger->host.port,
 		           logger->level);
 
 		if (oldConfig)
@@ -1,6 +1,8 @@
 #include <compartment.h>
 #include <debug.hh>
 
+#include "config/parser_compartment.h"
+
 // Expose debugging features unconditionally for this compartment.
 using Debug = ConditionalDebug<true, "Parser Init">;
 
@@ -17,9 +19,12 @@ using Debug = ConditionalDebug<true, "Parser Init">;
 // The thread that will eventually become the MQTT handler starts
 // in this compatement
 //
-int __cheri_compartment("parser_rgb_led") parse_rgb_led_init();
-int __cheri_compartment("parser_user_led") parse_user_led_init();
-int __cheri_compartment("parser_logger") parse_logger_init();
+int __cheri_compartment(PARSER_COMPARTMENT("parser_rgb_led"))
+  parse_rgb_led_init();
+int __cheri_compartment(PARSER_COMPARTMENT("parser_user_led"))
+  parse_user_led_init();
+int __cheri_compartment(PARSER_COMPARTMENT("parser_logger"))
+  parse_logger_init();
 
 // Next step after initalisation
 int __cheri_compartment("provider") provider_run();
@@ -0,0 +1,315 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Load generator that acts as a Provider, sending a stream of
+ * valid, invalid and duplicate updates across the load test items
+ * as fast as the Broker will take them or at a fixed rate.  It
+ * reports the updates accepted each second and the rejects by
+ * reason, and the load sink reports the latency seen by a consumer.
+ *
+ * The shape of the load is set when the firmware is configured, see
+ * the load-* options in xmake.lua.
+ */
+
+#include <compartment.h>
+#include <debug.hh>
+#include <errno.h>
+#include <fail-simulator-on-error.h>
+#include <riscvreg.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread.h>
+#include <tick_macros.h>
+
+// Expose debugging features unconditionally for this compartment.
+using Debug = ConditionalDebug<true, "Load Generator">;
+
+#include "common/config_broker/config_broker.h"
+#include "config/include/load_test.h"
+
+// Define the sealed capabilites for each of the load test items
+LOAD_TEST_ITEMS(DEFINE_WRITE_CONFIG_CAPABILITY_ID)
+
+#ifndef LOAD_ITEMS
+#	define LOAD_ITEMS 16
+#endif
+#ifndef LOAD_RATE
+#	define LOAD_RATE 0
+#endif
+#ifndef LOAD_SECONDS
+#	define LOAD_SECONDS 10
+#endif
+#ifndef LOAD_INVALID_PERCENT
+#	define LOAD_INVALID_PERCENT 10
+#endif
+#ifndef LOAD_DUPLICATE_PERCENT
+#	define LOAD_DUPLICATE_PERCENT 10
+#endif
+
+static_assert((LOAD_ITEMS > 0) && (LOAD_ITEMS <= loadTest::NumItems),
+              "LOAD_ITEMS must be between 1 and loadTest::NumItems");
+static_assert(LOAD_INVALID_PERCENT + LOAD_DUPLICATE_PERCENT <= 100,
+              "Invalid and duplicate updates can't exceed 100%");
+
+namespace
+{
+	const uint64_t TicksPerSecond = MS_TO_TICKS(1000);
+
+	/**
+	 * Kinds of update sent
+	 */
+	enum Kind
+	{
+		Valid,
+		Invalid,
+		Duplicate,
+		NumKinds
+	};
+
+	const char *KindNames[NumKinds] = {"valid", "invalid", "duplicate"};
+
+	/**
+	 * Results from set_config()
+	 */
+	enum Result
+	{
+		Accepted, // 0
+		Busy,     // -EBUSY, rate limited
+		Rejected, // -EINVAL, failed to parse
+		NoMemory, // -ENOMEM
+		Other,
+		NumResults
+	};
+
+	Result result_of(int res)
+	{
+		switch (res)
+		{
+			case 0:
+				return Accepted;
+			case -EBUSY:
+				return Busy;
+			case -EINVAL:
+				return Rejected;
+			case -ENOMEM:
+				return NoMemory;
+			default:
+				return Other;
+		}
+	}
+
+	using Counts = uint32_t[NumKinds][NumResults];
+
+	/**
+	 * The last update accepted for each item, resent verbatim
+	 * as a duplicate.
+	 */
+	struct Item
+	{
+		uint32_t sequence;   // Sequence number of the last accepted update
+		char     last[80];   // JSON of the last accepted update
+		size_t   lastLength; // 0 if no update has been accepted yet
+	};
+
+	Item items[LOAD_ITEMS];
+
+	/**
+	 * Small deterministic PRNG, so that runs with the same options
+	 * send the same sequence of updates.
+	 */
+	uint32_t next_random()
+	{
+		static uint32_t state = 0x12345678;
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	uint64_t now()
+	{
+		auto tick = thread_systemtick_get();
+		return (static_cast<uint64_t>(tick.hi) << 32) + tick.lo;
+	}
+
+	uint32_t sum(const Counts &counts, Result result)
+	{
+		uint32_t total = 0;
+		for (auto &kind : counts)
+		{
+			total += kind[result];
+		}
+		return total;
+	}
+
+	/**
+	 * Build the JSON for the next update to an item.  Invalid
+	 * updates alternate between a level that is out of range and
+	 * truncated JSON.
+	 */
+	size_t build(char *buffer, size_t size, uint16_t item, Kind kind)
+	{
+		static bool truncate;
+
+		uint32_t cycles = static_cast<uint32_t>(rdcycle64());
+		uint32_t level  = next_random() % (loadTest::MaxLevel + 1);
+		if (kind == Invalid)
+		{
+			level = loadTest::MaxLevel + 1 + level;
+		}
+
+		int length = snprintf(buffer,
+		                      size,
+		                      "{\"sequence\":%u,\"sent\":%u,\"item\":%u,"
+		                      "\"level\":%u}",
+		                      static_cast<unsigned>(items[item].sequence + 1),
+		                      static_cast<unsigned>(cycles),
+		                      static_cast<unsigned>(item),
+		                      static_cast<unsigned>(level));
+		if ((length < 0) || (static_cast<size_t>(length) >= size))
+		{
+			return 0;
+		}
+		if (kind == Invalid)
+		{
+			truncate = !truncate;
+			if (truncate)
+			{
+				length /= 2;
+			}
+		}
+		return length;
+	}
+
+	void report(const char *title, const Counts &counts, uint64_t ticks)
+	{
+		uint64_t ms       = (ticks * 1000) / TicksPerSecond;
+		uint32_t accepted = sum(counts, Accepted);
+		Debug::log("{}: {} accepted in {} mS ({}/s), rejected busy {} "
+		           "invalid {} no memory {} other {}",
+		           title,
+		           accepted,
+		           ms,
+		           ms > 0 ? (accepted * 1000ULL) / ms : 0,
+		           sum(counts, Busy),
+		           sum(counts, Rejected),
+		           sum(counts, NoMemory),
+		           sum(counts, Other));
+	}
+
+} // namespace
+
+/**
+ * Thread entry point, called from load_init once the parsers
+ * are registered.  Sends updates for LOAD_SECONDS and then reports
+ * the totals for each kind of update.
+ */
+void __cheri_compartment("load_generator") loadgen_run()
+{
+	WriteConfigCapability capabilities[] = {
+#define LOAD_TEST_CAPABILITY(Id) WRITE_CONFIG_CAPABILITY(Id),
+	  LOAD_TEST_ITEMS(LOAD_TEST_CAPABILITY)
+#undef LOAD_TEST_CAPABILITY
+	};
+
+	Debug::log("Sending to {} items at {}/s for {} s, {}% invalid, "
+	           "{}% duplicate",
+	           LOAD_ITEMS,
+	           LOAD_RATE,
+	           LOAD_SECONDS,
+	           LOAD_INVALID_PERCENT,
+	           LOAD_DUPLICATE_PERCENT);
+
+	Counts   total    = {};
+	Counts   interval = {};
+	uint64_t sent     = 0;
+	uint16_t item     = 0;
+	char     buffer[sizeof(items[0].last)];
+
+	uint64_t start      = now();
+	uint64_t end        = start + LOAD_SECONDS * TicksPerSecond;
+	uint64_t lastReport = start;
+	uint64_t tick;
+	while ((tick = now()) < end)
+	{
+		if (tick - lastReport >= TicksPerSecond)
+		{
+			report("Last second", interval, tick - lastReport);
+			memset(interval, 0, sizeof(interval));
+			lastReport = tick;
+		}
+
+		// Keep to the rate by working out how many updates should
+		// have been sent by now, and sleeping for a tick if we're
+		// ahead.
+		if ((LOAD_RATE > 0) &&
+		    (sent >= ((tick - start) * LOAD_RATE) / TicksPerSecond))
+		{
+			Timeout t{1};
+			thread_sleep(&t, ThreadSleepNoEarlyWake);
+			continue;
+		}
+
+		uint32_t choice = next_random() % 100;
+		Kind     kind   = Valid;
+		if (choice < LOAD_INVALID_PERCENT)
+		{
+			kind = Invalid;
+		}
+		else if ((choice < LOAD_INVALID_PERCENT + LOAD_DUPLICATE_PERCENT) &&
+		         (items[item].lastLength > 0))
+		{
+			kind = Duplicate;
+		}
+
+		const char *json   = buffer;
+		size_t      length = 0;
+		if (kind == Duplicate)
+		{
+			json   = items[item].last;
+			length = items[item].lastLength;
+		}
+		else
+		{
+			length = build(buffer, sizeof(buffer), item, kind);
+		}
+
+		int    res    = set_config(capabilities[item], json, length);
+		Result result = result_of(res);
+		total[kind][result]++;
+		interval[kind][result]++;
+		sent++;
+
+		if ((kind == Valid) && (result == Accepted))
+		{
+			items[item].sequence++;
+			memcpy(items[item].last, buffer, length + 1);
+			items[item].lastLength = length;
+		}
+		if ((kind != Invalid) && (result == Rejected))
+		{
+			Debug::log("Unexpected parse failure for {}", json);
+		}
+		if ((kind == Invalid) && (result == Accepted))
+		{
+			Debug::log("Invalid update accepted {}", json);
+		}
+
+		item = (item + 1) % LOAD_ITEMS;
+	}
+
+	Debug::log("---- Finished ----");
+	report("Total", total, now() - start);
+	for (int kind = 0; kind < NumKinds; kind++)
+	{
+		Debug::log("{} updates: accepted {}, rejected busy {} invalid {} "
+		           "no memory {} other {}",
+		           KindNames[kind],
+		           total[kind][Accepted],
+		           total[kind][Busy],
+		           total[kind][Rejected],
+		           total[kind][NoMemory],
+		           total[kind][Other]);
+	}
+}
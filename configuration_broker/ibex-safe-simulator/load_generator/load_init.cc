@@ -0,0 +1,44 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+#include <compartment.h>
+#include <debug.hh>
+
+#include "config/include/load_test.h"
+#include "config/parser_compartment.h"
+
+// Expose debugging features unconditionally for this compartment.
+using Debug = ConditionalDebug<true, "Load Init">;
+
+//
+// As parser_init, but for the load test parsers.  The thread that
+// runs the load generator starts in this compartment and registers
+// each of the parsers before it starts sending updates.
+//
+#define LOAD_TEST_INIT(Id)                                                     \
+	int __cheri_compartment(PARSER_COMPARTMENT("parser_load_test"))            \
+	  parse_##Id##_init();
+LOAD_TEST_ITEMS(LOAD_TEST_INIT)
+#undef LOAD_TEST_INIT
+
+// Next step after initalisation
+void __cheri_compartment("load_generator") loadgen_run();
+
+void __cheri_compartment("load_init") load_init()
+{
+	int res = 0;
+#define LOAD_TEST_INIT(Id) res = std::min(res, parse_##Id##_init());
+	LOAD_TEST_ITEMS(LOAD_TEST_INIT)
+#undef LOAD_TEST_INIT
+
+	if (res == 0)
+	{
+		// All good - start sending updates
+		Debug::log("Parsers initialised");
+		loadgen_run();
+	}
+	else
+	{
+		Debug::log("One of more parsers failed to initialise");
+	}
+}
@@ -0,0 +1,160 @@
+// Copyright Configured Things and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Consumer for the load test items, which measures how long each
+ * update took to reach it from the load generator and counts the
+ * updates that it never saw (because a later one arrived first) or
+ * saw more than once (duplicates accepted by the Broker).
+ */
+
+#include <compartment.h>
+#include <cstdlib>
+#include <debug.hh>
+#include <fail-simulator-on-error.h>
+#include <riscvreg.h>
+#include <thread.h>
+#include <tick_macros.h>
+#include <token.h>
+
+// Define sealed capabilities that gives this compartment
+// read access to each of the load test items
+#include "common/config_broker/config_broker.h"
+#include "config/include/load_test.h"
+
+LOAD_TEST_ITEMS(DEFINE_READ_CONFIG_CAPABILITY_ID)
+
+// Expose debugging features unconditionally for this compartment.
+using Debug = ConditionalDebug<true, "Load Sink">;
+
+#include "common/config_consumer/config_consumer.h"
+
+namespace
+{
+	const uint64_t TicksPerSecond = MS_TO_TICKS(1000);
+
+	/**
+	 * Latency, in cycles, of the updates received
+	 */
+	struct Latency
+	{
+		uint32_t count;
+		uint32_t min;
+		uint32_t max;
+		uint64_t total;
+
+		void add(uint32_t cycles)
+		{
+			if ((count == 0) || (cycles < min))
+			{
+				min = cycles;
+			}
+			if (cycles > max)
+			{
+				max = cycles;
+			}
+			total += cycles;
+			count++;
+		}
+
+		void report(const char *title, uint64_t ticks)
+		{
+			uint64_t ms = (ticks * 1000) / TicksPerSecond;
+			Debug::log("{}: {} updates in {} mS ({}/s), latency cycles "
+			           "min {} avg {} max {}",
+			           title,
+			           count,
+			           ms,
+			           ms > 0 ? (count * 1000ULL) / ms : 0,
+			           min,
+			           count > 0 ? total / count : 0,
+			           max);
+		}
+	};
+
+	Latency  total;
+	Latency  interval;
+	uint32_t missed;     // Updates superseded before we saw them
+	uint32_t duplicates; // Updates we had already seen
+
+	uint32_t lastSequence[loadTest::NumItems];
+
+	uint64_t start;      // Tick of the first update
+	uint64_t latest;     // Tick of the most recent update
+	uint64_t lastReport; // Tick of the last interval report
+
+	uint64_t now()
+	{
+		auto tick = thread_systemtick_get();
+		return (static_cast<uint64_t>(tick.hi) << 32) + tick.lo;
+	}
+
+	/**
+	 * Handle an update to any of the load test items.  The consumer
+	 * helper has already made a fast claim on the value, and we
+	 * only need it for the duration of this call.
+	 */
+	int load_handler(void *newConfig)
+	{
+		uint32_t cycles = static_cast<uint32_t>(rdcycle64());
+		auto     config = static_cast<loadTest::Config *>(newConfig);
+		uint64_t tick   = now();
+
+		if (start == 0)
+		{
+			start      = tick;
+			lastReport = tick;
+		}
+		latest = tick;
+
+		// The parser has checked the item is in range
+		auto &last = lastSequence[config->item];
+		if (config->sequence <= last)
+		{
+			duplicates++;
+			return 0;
+		}
+		missed += config->sequence - last - 1;
+		last = config->sequence;
+
+		// Wraps safely as long as the latency is less than 2^32 cycles
+		uint32_t latency = cycles - config->sent;
+		total.add(latency);
+		interval.add(latency);
+
+		if (tick - lastReport >= TicksPerSecond)
+		{
+			interval.report("Last second", tick - lastReport);
+			interval   = {};
+			lastReport = tick;
+		}
+		return 0;
+	}
+
+} // namespace
+
+/**
+ * Thread entry point.  Handles updates until the load generator
+ * has been idle for a couple of seconds and then reports the
+ * totals.
+ */
+void __cheri_compartment("load_sink") init()
+{
+	ConfigConsumer::ConfigItem configItems[] = {
+#define LOAD_TEST_ITEM(Id)                                                     \
+	{READ_CONFIG_CAPABILITY(Id), load_handler, 0, nullptr},
+	  LOAD_TEST_ITEMS(LOAD_TEST_ITEM)
+#undef LOAD_TEST_ITEM
+	};
+
+	size_t numOfItems = sizeof(configItems) / sizeof(configItems[0]);
+
+	const ConfigConsumer::IdlePolicy Policy = {1000, 1000, 1, nullptr};
+	ConfigConsumer::run(configItems, numOfItems, 2, &Policy);
+
+	Debug::log("---- Finished ----");
+	total.report("Total", latest - start);
+	Debug::log("Updates superseded before they were seen {}, duplicates {}",
+	           missed,
+	           duplicates);
+}
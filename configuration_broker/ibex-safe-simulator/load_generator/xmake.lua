@@ -0,0 +1,50 @@
+-- Copyright Configured Things Ltd and CHERIoT Contributors.
+-- SPDX-License-Identifier: MIT
+
+
+option("load-items")
+    set_default("16")
+    set_description("Number of config items the load generator updates, up to 16")
+
+option("load-rate")
+    set_default("0")
+    set_description("Updates per second sent by the load generator, 0 to send as fast as possible")
+
+option("load-seconds")
+    set_default("10")
+    set_description("How long the load generator runs for in seconds")
+
+option("load-invalid")
+    set_default("10")
+    set_description("Percentage of updates that are invalid")
+
+option("load-duplicate")
+    set_default("10")
+    set_description("Percentage of updates that repeat the last accepted update for the item")
+
+-- Initialisation compartment for the load test parsers
+compartment("load_init")
+    set_default(false)
+    add_includedirs("../..")
+    add_files("load_init.cc")
+
+-- Load generator, acting as a Provider
+compartment("load_generator")
+    set_default(false)
+    add_includedirs("../..")
+    add_files("load_generator.cc")
+
+    on_load(function(target)
+        target:add('options', "load-items", "load-rate", "load-seconds", "load-invalid", "load-duplicate")
+        target:add("defines", "LOAD_ITEMS=" .. tostring(get_config("load-items")))
+        target:add("defines", "LOAD_RATE=" .. tostring(get_config("load-rate")))
+        target:add("defines", "LOAD_SECONDS=" .. tostring(get_config("load-seconds")))
+        target:add("defines", "LOAD_INVALID_PERCENT=" .. tostring(get_config("load-invalid")))
+        target:add("defines", "LOAD_DUPLICATE_PERCENT=" .. tostring(get_config("load-duplicate")))
+    end)
+
+-- Consumer of the load test items
+compartment("load_sink")
+    set_default(false)
+    add_includedirs("../..")
+    add_files("load_sink.cc")
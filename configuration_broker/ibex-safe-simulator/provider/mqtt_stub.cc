@@ -69,7 +69,7 @@ namespace
 
 	/**
 	 * Define a data struct for the Logger conf, send
-	 * as a byte format
+	 * as a byte format with the address as text
 	 */
 	struct Logger
 	{
@@ -158,6 +158,14 @@ void __cheri_compartment("provider") provider_run()
 	Timeout t2{MS_TO_TICKS(500)};
 	thread_sleep(&t2, ThreadSleepNoEarlyWake);
 
+	Debug::log("-------- Logger (Malformed address) --------");
+	strcpy(loggerConfig.address, "100.101.999..1");
+	res = updateConfig("logger", 6, &loggerConfig, sizeof(loggerConfig));
+	Debug::Assert(res == -EINVAL, "Unexpected result {}", res);
+
+	Timeout t5{MS_TO_TICKS(500)};
+	thread_sleep(&t5, ThreadSleepNoEarlyWake);
+
 	Debug::log("-------- Logger (Invalid address and port) --------");
 	strcpy(loggerConfig.address, "invalidAddress");
 	loggerConfig.port = 0;
@@ -9,13 +9,20 @@ set_toolchains("cheriot-clang")
 
 -- Support libraries
 includes(path.join(sdkdir, "lib/freestanding"),
+         path.join(sdkdir, "lib/stdio"),
          path.join(sdkdir, "lib/string"))
 
 option("board")
     set_default("ibex-safe-simulator")
 
+option("combined_parsers")
+    set_default(false)
+    set_description("Build all of the parsers into a single sandbox compartment")
+    add_defines("COMBINED_PARSERS")
+
 -- Common libraries and compartments
 includes("../../third_party/json_parser")
+includes("../../third_party/cbor_parser")
 includes("../common/config_broker") 
 includes("../common/config_consumer")
 
@@ -25,29 +32,49 @@ includes("init")
 -- Mocked MQTT Client to provide configurtaion
 includes("provider")
 
--- Configuration JSON parser sandboxes
-includes("../config/parsers/rgb_led")
-includes("../config/parsers/user_led")
-includes("../config/parsers/logger")
+-- Configuration JSON parser sandboxes, either one per item
+-- or all in a single compartment
+if has_config("combined_parsers") then
+    compartment("parsers")
+        set_default(false)
+        add_includedirs("..")
+        add_options("combined_parsers")
+        add_files("../config/parsers/rgb_led/parser.cc")
+        add_files("../config/parsers/user_led/parser.cc")
+        add_files("../config/parsers/logger/parser.cc")
+else
+    includes("../config/parsers/rgb_led")
+    includes("../config/parsers/user_led")
+    includes("../config/parsers/logger")
+end
 
 -- Consumers
 includes("consumers")
 
+-- Load generator, its parsers, and a consumer to measure latency
+includes("load_generator")
+includes("../config/parsers/load_test")
+
 -- Firmware image for the example.
 firmware("config-broker-ibex-sim")
     add_deps("freestanding", "debug", "string")
 
     -- libraries
     add_deps("json_parser")
+    add_deps("cbor_parser")
     add_deps("config_consumer")
     
     -- compartments
     add_deps("parser_init")
     add_deps("provider")
     add_deps("config_broker")
-    add_deps("parser_logger")
-    add_deps("parser_rgb_led")
-    add_deps("parser_user_led")
+    if has_config("combined_parsers") then
+        add_deps("parsers")
+    else
+        add_deps("parser_logger")
+        add_deps("parser_rgb_led")
+        add_deps("parser_user_led")
+    end
     add_deps("consumer1")
     add_deps("consumer2")
     on_load(function(target)
@@ -84,4 +111,45 @@ firmware("config-broker-ibex-sim")
         }, {expand = false})
     end)
 
+-- Firmware image for the load test.  The shape of the load is set
+-- with the load-* options, for example
+--   xmake config --load-rate=2000 --load-invalid=20
+firmware("config-broker-ibex-sim-load")
+    set_default(false)
+    add_deps("freestanding", "debug", "string", "stdio")
+
+    -- libraries
+    add_deps("json_parser")
+    add_deps("cbor_parser")
+    add_deps("config_consumer")
 
+    -- compartments
+    add_deps("load_init")
+    add_deps("load_generator")
+    add_deps("config_broker")
+    add_deps("parser_load_test")
+    add_deps("load_sink")
+    on_load(function(target)
+        target:values_set("board", "$(board)")
+        target:values_set("threads", {
+            {
+                -- Thread to generate the load.
+                -- Starts in the load_init compartment
+                -- and then loops in the load_generator.
+                compartment = "load_init",
+                priority = 1,
+                entry_point = "load_init",
+                stack_size = 0x800,
+                trusted_stack_frames = 8
+            },
+            {
+                -- Thread to consume the load test items.
+                -- Starts and loops in load_sink
+                compartment = "load_sink",
+                priority = 2,
+                entry_point = "init",
+                stack_size = 0x500,
+                trusted_stack_frames = 4
+            },
+        }, {expand = false})
+    end)
@@ -1,6 +1,8 @@
 #include <compartment.h>
 #include <debug.hh>
 
+#include "config/parser_compartment.h"
+
 // Expose debugging features unconditionally for this compartment.
 using Debug = ConditionalDebug<true, "Parser Init">;
 
@@ -17,9 +19,14 @@ using Debug = ConditionalDebug<true, "Parser Init">;
 // The thread that calls this should do so before it calls into
 // any compartment that handles untrusted data
 //
-int __cheri_compartment("parser_rgb_led") parse_rgb_led_init();
-int __cheri_compartment("parser_user_led") parse_user_led_init();
-int __cheri_compartment("parser_system_config") parse_system_config_init();
+int __cheri_compartment(PARSER_COMPARTMENT("parser_rgb_led"))
+  parse_rgb_led_init();
+int __cheri_compartment(PARSER_COMPARTMENT("parser_user_led"))
+  parse_user_led_init();
+int __cheri_compartment(PARSER_COMPARTMENT("parser_system_config"))
+  parse_system_config_init();
+int __cheri_compartment(PARSER_COMPARTMENT("parser_keyring"))
+  parse_keyring_init();
 
 // Next step in initialisation
 int __cheri_compartment("system_config") system_config_run();
@@ -31,6 +38,7 @@ void __cheri_compartment("parser_init") parser_init()
 	auto res = parse_user_led_init();
 	res      = std::min(res, parse_rgb_led_init());
 	res      = std::min(res, parse_system_config_init());
+	res      = std::min(res, parse_keyring_init());
 
 	if (res == 0)
 	{
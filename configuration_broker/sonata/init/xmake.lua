@@ -4,6 +4,8 @@
 
 compartment("parser_init")
     set_default(false)
+    add_includedirs("../..")
+    add_options("combined_parsers")
     add_files("parser_init.cc")
     
 compartment("network_init")
@@ -17,6 +17,7 @@ using Debug = ConditionalDebug<true, "Provider_Config">;
  * items this compartment is allowed to update
  */
 #include "common/config_broker/config_broker.h"
+#include "common/config_broker/config_item_map.h"
 
 #define RGB_LED_CONFIG "rgb_led"
 DEFINE_WRITE_CONFIG_CAPABILITY(RGB_LED_CONFIG)
@@ -24,35 +25,24 @@ DEFINE_WRITE_CONFIG_CAPABILITY(RGB_LED_CONFIG)
 #define USER_LED_CONFIG "user_led"
 DEFINE_WRITE_CONFIG_CAPABILITY(USER_LED_CONFIG)
 
+#define KEYRING_CONFIG "keyring"
+DEFINE_WRITE_CONFIG_CAPABILITY(KEYRING_CONFIG)
+
 namespace
 {
 
 	/**
-	 * Map of Config names to capabilites
+	 * Map of Config names to capabilites, built at compile time
+	 * so that each name is found with an exact match in constant
+	 * time.
 	 */
-	struct Config
-	{
-		const char *name;
-		WriteConfigCapability cap; // Sealed Write Capability
+	constexpr ConfigItemName ConfigItems[] = {
+	  CONFIG_ITEM_NAME("rgb_LED", RGB_LED_CONFIG),
+	  CONFIG_ITEM_NAME("user_LED", USER_LED_CONFIG),
+	  CONFIG_ITEM_NAME("keyring", KEYRING_CONFIG),
 	};
 
-	// We can't use the macros at the file level to statically
-	// initialise configItemMap, so do it via a function
-	Config configItemMap[2];
-	void   set_up_name_map()
-	{
-		static bool init = false;
-		if (!init)
-		{
-			configItemMap[0].name = "rgb_LED";
-			configItemMap[0].cap  = WRITE_CONFIG_CAPABILITY(RGB_LED_CONFIG);
-
-			configItemMap[1].name = "user_LED";
-			configItemMap[1].cap  = WRITE_CONFIG_CAPABILITY(USER_LED_CONFIG);
-
-			init = true;
-		}
-	}
+	constexpr ConfigItemMap itemMap{ConfigItems};
 
 } // namespace
 
@@ -69,31 +59,22 @@ int updateConfig(const char *name,
 	std::string_view svJson((char *)json, jsonLength);
 	Debug::log("thread {} update {}: {}", thread_id_get(), svName, svJson);
 
-	// Initalise the name map
-	set_up_name_map();
+	int res = -1;
 
-	bool found = false;
-	int  res   = -1;
-
-	// Use the configItemMap to work out which value the
+	// Use the itemMap to work out which value the
 	// message is for.
-	for (auto t : configItemMap)
+	auto *item = itemMap.find(name, nameLength);
+	if (item != nullptr)
 	{
-		if (strncmp(t.name, name, nameLength) == 0)
+		auto cap = item->capability();
+		res      = set_config(cap, (const char *)json, jsonLength);
+		if (res < 0)
 		{
-			found = true;
-			res   = set_config(t.cap, (const char *)json, jsonLength);
-			if (res < 0)
-			{
-				Debug::log("thread {} Failed to set value for {}",
-				           thread_id_get(),
-				           t.cap);
-			}
-			break;
+			Debug::log(
+			  "thread {} Failed to set value for {}", thread_id_get(), cap);
 		}
 	}
-
-	if (!found)
+	else
 	{
 		Debug::log(
 		  "thread {} Unknown config item name {}", thread_id_get(), svName);
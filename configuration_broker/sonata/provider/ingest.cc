@@ -0,0 +1,211 @@
+// Copyright Configured Things and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <debug.hh>
+#include <string.h>
+#include <string_view>
+#include <thread.h>
+#include <tick_macros.h>
+
+#include "ingest.h"
+#include "signature.h"
+
+// Expose debugging features unconditionally for this compartment.
+using Debug = ConditionalDebug<true, "Ingest">;
+
+namespace
+{
+	/// Time to wait after subscribing for the retained items to arrive
+	constexpr uint32_t IngestWindowMs = 500;
+
+	/// Time to keep collecting after each message, so that a burst
+	/// that is still arriving isn't split
+	constexpr uint32_t IngestQuietMs = 250;
+
+	/// Longest time to collect for after the window is opened
+	constexpr uint32_t IngestMaxMs = 2000;
+
+	/// Most items that can be held at once
+	constexpr size_t MaxPending = 8;
+
+	/**
+	 * A message held for an item.  A slot with an idLength of 0 is
+	 * free.
+	 */
+	struct Pending
+	{
+		char               id[24];
+		size_t             idLength;
+		void              *payload;
+		size_t             payloadLength;
+		SIGNATURE::Counter counter; // Read from the unverified context
+	};
+
+	Pending pending[MaxPending];
+
+	bool     windowOpen  = false;
+	uint64_t windowEnd   = 0; // System tick the window closes at
+	uint64_t windowLimit = 0; // Latest the window can be extended to
+
+	uint64_t now()
+	{
+		auto system_tick = thread_systemtick_get();
+		return (static_cast<uint64_t>(system_tick.hi) << 32) + system_tick.lo;
+	}
+
+	void release(Pending &p)
+	{
+		free(p.payload);
+		p = {};
+	}
+
+	bool is_for(const Pending &p, std::string_view id)
+	{
+		return (p.idLength != 0) && (std::string_view{p.id, p.idLength} == id);
+	}
+
+	/**
+	 * Apply the messages held for an item, highest counter first,
+	 * until one is applied, and release them all.  The counters
+	 * haven't been verified, so a forged message with a high counter
+	 * may be tried first, but it can't stop a genuine one from being
+	 * applied after it.  Returns true if a message was applied.
+	 */
+	bool apply_item(std::string_view item, IngestHandler apply)
+	{
+		// The item may be the id in one of the slots being released
+		char   id[sizeof(Pending::id)];
+		size_t idLength = std::min(item.size(), sizeof(id));
+		memcpy(id, item.data(), idLength);
+		std::string_view svId{id, idLength};
+
+		bool applied = false;
+		while (true)
+		{
+			Pending *next = nullptr;
+			for (auto &p : pending)
+			{
+				if (is_for(p, svId) &&
+				    ((next == nullptr) ||
+				     (p.counter.value > next->counter.value)))
+				{
+					next = &p;
+				}
+			}
+			if (next == nullptr)
+			{
+				return applied;
+			}
+			if (!applied)
+			{
+				applied = apply(
+				  next->id, next->idLength, next->payload, next->payloadLength);
+			}
+			release(*next);
+		}
+	}
+} // namespace
+
+void open_ingest_window()
+{
+	uint64_t tick = now();
+	windowLimit   = tick + MS_TO_TICKS(IngestMaxMs);
+	windowEnd     = tick + MS_TO_TICKS(IngestWindowMs);
+	windowOpen    = true;
+}
+
+bool ingest_message(const char *id,
+                    size_t      idLength,
+                    const void *payload,
+                    size_t      payloadLength)
+{
+	if (!windowOpen || (idLength == 0) || (idLength > sizeof(Pending::id)))
+	{
+		return false;
+	}
+
+	// A message without a key id and counter can't be compared with
+	// the others for its item, and will fail to verify anyway.
+	std::string_view   svId{id, idLength};
+	SIGNATURE::Counter counter;
+	if (!SIGNATURE::read_counter(payload, payloadLength, &counter))
+	{
+		return false;
+	}
+
+	// Nothing is replaced, as the messages haven't been verified and
+	// a bad one mustn't displace a good one.  If this one can't be
+	// held and is applied now, any held for the item with a lower
+	// counter from the same key are rejected as replays later.
+	Pending *slot = nullptr;
+	for (auto &p : pending)
+	{
+		if (is_for(p, svId) && (p.payloadLength == payloadLength) &&
+		    (memcmp(p.payload, payload, payloadLength) == 0))
+		{
+			Debug::log("Dropping duplicate message for {}", svId);
+			return true;
+		}
+		if ((slot == nullptr) && (p.idLength == 0))
+		{
+			slot = &p;
+		}
+	}
+	if (slot == nullptr)
+	{
+		Debug::log("No space to hold {}", svId);
+		return false;
+	}
+
+	void *copy = malloc(payloadLength);
+	if (copy == nullptr)
+	{
+		Debug::log("Failed to allocate space to hold {}", svId);
+		return false;
+	}
+	memcpy(copy, payload, payloadLength);
+
+	memcpy(slot->id, id, idLength);
+	slot->idLength      = idLength;
+	slot->payload       = copy;
+	slot->payloadLength = payloadLength;
+	slot->counter       = counter;
+
+	// Extend the window while messages keep arriving, but never
+	// shorten it or let it run past the limit
+	windowEnd = std::min(
+	  std::max(windowEnd, now() + MS_TO_TICKS(IngestQuietMs)), windowLimit);
+	return true;
+}
+
+Ticks flush_ingest(IngestHandler apply, std::string_view first)
+{
+	if (!windowOpen)
+	{
+		return 0;
+	}
+
+	uint64_t tick = now();
+	if (tick < windowEnd)
+	{
+		return static_cast<Ticks>(windowEnd - tick);
+	}
+	windowOpen = false;
+
+	// Apply the first item (the keyring) before anything that
+	// might be signed with one of its keys.
+	size_t applied = apply_item(first, apply) ? 1 : 0;
+	for (auto &p : pending)
+	{
+		if ((p.idLength != 0) && apply_item({p.id, p.idLength}, apply))
+		{
+			applied++;
+		}
+	}
+	Debug::log("Applied {} held config messages", applied);
+
+	return 0;
+}
@@ -0,0 +1,30 @@
+// Copyright Configured Things and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+// Handler for a config message, given the last element of its topic
+// and the signed payload.  Returns true if the message was applied.
+using IngestHandler = bool (*)(const char *id,
+                               size_t      idLength,
+                               const void *payload,
+                               size_t      payloadLength);
+
+// Start collecting config messages rather than applying them as they
+// arrive.  Call before subscribing, as the broker sends every retained
+// item in one burst as soon as it has the subscription.
+void open_ingest_window();
+
+// Hold a config message until the window closes.  An exact duplicate of
+// a message already held is dropped.  Returns false if the window isn't
+// open or the message can't be held, in which case it should be applied
+// now.
+bool ingest_message(const char *id,
+                    size_t      idLength,
+                    const void *payload,
+                    size_t      payloadLength);
+
+// Once the window has closed, apply one message for each item, starting
+// with first if there is one.  The held messages for an item are tried
+// highest counter first until one is applied, so one that doesn't verify
+// can't stop an older genuine message being applied.  Returns the number
+// of ticks until the window will close, or 0 if it isn't open.
+Ticks flush_ingest(IngestHandler apply, std::string_view first);
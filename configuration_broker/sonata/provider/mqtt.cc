@@ -2,11 +2,13 @@
 // SPDX-License-Identifier: MIT
 
 #include <NetAPI.h>
+#include <algorithm>
 #include <cstdlib>
 #include <debug.hh>
 #include <errno.h>
 #include <locks.hh>
 #include <mqtt.h>
+#include <multiwaiter.h>
 #include <platform-entropy.hh>
 #include <sntp.h>
 #include <tick_macros.h>
@@ -14,10 +16,14 @@
 
 #include "mosquitto.org.h"
 
+#include "../../../third_party/mqtt_reconnect/reconnect.h"
+
 #include "config/include/system_config.h"
 
 #include "signature.h"
 #include "config.h"
+#include "ingest.h"
+#include "publish_queue.h"
 #include "status.h"
 
 // Define sealed capability that gives this compartment
@@ -46,11 +52,33 @@ constexpr const size_t networkBufferSize    = 1024;
 constexpr const size_t incomingPublishCount = 10;
 constexpr const size_t outgoingPublishCount = 10;
 
-// MQTT test broker: https://test.mosquitto.org/
+/// Keepalive interval the MQTT stack gives the broker.  mqtt.h doesn't
+/// export it, so this has to match the stack.
+constexpr uint32_t MqttKeepAliveMs = 60 * 1000;
+
+/// Time between letting the MQTT stack run, which is also how long a
+/// message from the broker can wait to be picked up.  The socket can't
+/// be waited on, so the stack is polled every MinServiceMs while there
+/// is traffic, and the interval doubles on each idle pass up to a
+/// quarter of the keepalive interval, which leaves the stack time to
+/// send a PINGREQ before the broker drops the connection.
+constexpr uint32_t MinServiceMs = 100;
+constexpr uint32_t MaxServiceMs = MqttKeepAliveMs / 4;
+
+/// How long each call to mqtt_run waits for traffic from the broker.
+/// The system config futex can't be waited on at the same time, so
+/// this is kept short and the rest of the service interval is spent
+/// in the futex wait, where a change wakes the loop straight away.
+constexpr uint32_t MqttRunMs = 10;
+
+/// Time allowed for each attempt to connect to the broker
+constexpr uint32_t ConnectTimeoutMs = 30 * 1000;
+
+// MQTT broker, by default the test broker https://test.mosquitto.org/
 // Note: port 8883 is encrypted and unautenticated
 DECLARE_AND_DEFINE_CONNECTION_CAPABILITY(MosquittoOrgMQTT,
-                                         "test.mosquitto.org",
-                                         8883,
+                                         MQTT_BROKER_HOST,
+                                         MQTT_BROKER_PORT,
                                          ConnectionTypeTCP);
 
 DECLARE_AND_DEFINE_ALLOCATOR_CAPABILITY(mqttTestMalloc, 32 * 1024);
@@ -58,6 +86,13 @@ DECLARE_AND_DEFINE_ALLOCATOR_CAPABILITY(mqttTestMalloc, 32 * 1024);
 std::string config_topic;
 std::string status_topic;
 
+/// Last element of the config topic for the signing keyring
+constexpr std::string_view KeyringTopic{"keyring"};
+
+/// Count of messages received, so the main loop can tell if a call
+/// to mqtt_run did any work.
+uint32_t messagesReceived = 0;
+
 /**
  * Generate config and status topics from an assigned system ID
  */
@@ -79,9 +114,40 @@ void generate_topics(char *id)
 	status_topic.append(id, strlen(id));
 }
 
+/**
+ * Verify a configuration message and pass it to the broker.  The
+ * configuration item being updated is given by id.  The message's
+ * counter is only recorded once the broker has accepted it, so a
+ * redelivery of a message that was rate limited or failed to parse
+ * isn't rejected as a replay.  Returns true if the message was
+ * applied.
+ */
+bool apply_message(const char *id,
+                   size_t      idLength,
+                   const void *payload,
+                   size_t      payloadLength)
+{
+	// Only the root key can sign changes to the keyring
+	std::string_view item{id, idLength};
+	bool             rootKeyOnly = (item == KeyringTopic);
+
+	SIGNATURE::Counter counter;
+	auto               msg = SIGNATURE::verify_signature(
+	  item, payload, payloadLength, &counter, rootKeyOnly);
+	if ((msg.data == nullptr) ||
+	    (updateConfig(id, idLength, msg.data, msg.length) != 0))
+	{
+		return false;
+	}
+	SIGNATURE::record_applied(item, counter);
+	return true;
+}
+
 /**
  * Handle any incomming configuration messages.  The configurtaion
- * item being updated is the last element of the topic
+ * item being updated is the last element of the topic.  Messages
+ * that arrive in the burst after subscribing are held so that only
+ * one for each item is applied.
  */
 void __cheri_callback publishCallback(const char *topic,
                                       size_t      topicLength,
@@ -90,6 +156,7 @@ void __cheri_callback publishCallback(const char *topic,
 {
 	Debug::log("Received a message on topic '{}'",
 	           std::string_view{topic, topicLength});
+	messagesReceived++;
 
 	// Extract the config ID from the topic
 	size_t idOffset = config_topic.size() - 1;
@@ -99,10 +166,9 @@ void __cheri_callback publishCallback(const char *topic,
 		const char *id       = topic + idOffset;
 		size_t      idLength = topicLength - idOffset;
 
-		auto msg = SIGNATURE::verify_signature(payload, payloadLength);
-		if (msg.data != nullptr)
+		if (!ingest_message(id, idLength, payload, payloadLength))
 		{
-			updateConfig(id, idLength, msg.data, msg.length);
+			apply_message(id, idLength, payload, payloadLength);
 		}
 	}
 	else
@@ -112,16 +178,41 @@ void __cheri_callback publishCallback(const char *topic,
 }
 
 /**
- * Check for changes in system status.
+ * Check for changes in system status.  On return seen holds the
+ * version that was read and the futex to wait on for the next one.
+ * newConnection is set for the first call on each connection.
  */
-int update_status(ReadConfigCapability configHandle, MQTTConnection mqttHandle)
+int update_status(ReadConfigCapability configHandle,
+                  MQTTConnection       mqttHandle,
+                  ConfigItem          *seen,
+                  bool                 newConnection)
 {
 	static bool                  subscribed    = false;
 	static uint32_t              configVersion = 0;
 	static systemConfig::Config *sysConfig;
 
+	// The broker doesn't keep our subscription from one connection
+	// to the next, so subscribe again to the current topic.
+	if (newConnection && (sysConfig != nullptr))
+	{
+		Debug::log("Resubscribing to topic '{}'", config_topic.c_str());
+		open_ingest_window();
+		Timeout t{5000};
+		auto    ret = mqtt_subscribe(&t,
+		                             mqttHandle,
+		                             1, // QoS 1 = delivered at least once
+		                             config_topic.data(),
+		                             config_topic.size());
+		if (ret < 0)
+		{
+			Debug::log("Failed to resubscribe, error {}.", ret);
+			return -1;
+		}
+	}
+
 	// read the current system config
 	auto config = get_config(configHandle);
+	*seen       = config;
 	if (config.data == nullptr)
 	{
 		Debug::log("No System Config data yet");
@@ -163,7 +254,7 @@ int update_status(ReadConfigCapability configHandle, MQTTConnection mqttHandle)
 	{
 		if (subscribed)
 		{
-			clear_status(mqttHandle, status_topic);
+			clear_status(status_topic);
 			auto ret = mqtt_unsubscribe(&t,
 			                            mqttHandle,
 			                            1, // QoS 1 = delivered at least once
@@ -182,6 +273,7 @@ int update_status(ReadConfigCapability configHandle, MQTTConnection mqttHandle)
 		Debug::log("Subscribing to topic '{}' ({} bytes)",
 		           config_topic.c_str(),
 		           config_topic.size());
+		open_ingest_window();
 		auto ret = mqtt_subscribe(&t,
 		                          mqttHandle,
 		                          1, // QoS 1 = delivered at least once
@@ -196,7 +288,7 @@ int update_status(ReadConfigCapability configHandle, MQTTConnection mqttHandle)
 		subscribed = true;
 	}
 
-	send_status(mqttHandle, status_topic, sysConfig);
+	queue_status(sysConfig);
 
 	return 0;
 }
@@ -215,16 +307,30 @@ void __cheri_compartment("provider") provider_run()
 	mqtt_generate_client_id(clientID.data() + clientIDPrefix.size(),
 	                        clientID.size() - clientIDPrefix.size());
 
+	// Create a multiwaiter to sleep on between calls into the
+	// MQTT stack
+	MultiWaiter mw = nullptr;
+	multiwaiter_create(&t, MALLOC_CAPABILITY, &mw, 1);
+	if (mw == nullptr)
+	{
+		Debug::log("Failed to create multiwaiter");
+		return;
+	}
+
+	// The client ID stays the same for every connection, so the
+	// broker sees one client reconnecting rather than a new one.
+	ReconnectBackoff backoff;
 	while (true)
 	{
+		backoff.wait();
 		Debug::log("Connecting to MQTT broker...");
 
-		t               = UnlimitedTimeout;
+		t               = Timeout{MS_TO_TICKS(ConnectTimeoutMs)};
 		auto mqttHandle = mqtt_connect(&t,
 		                               STATIC_SEALED_VALUE(mqttTestMalloc),
 		                               CONNECTION_CAPABILITY(MosquittoOrgMQTT),
 		                               publishCallback,
-		                               nullptr,
+		                               publish_ack,
 		                               TAs,
 		                               TAs_NUM,
 		                               networkBufferSize,
@@ -240,6 +346,18 @@ void __cheri_compartment("provider") provider_run()
 		}
 
 		Debug::log("Connected to MQTT broker!");
+		backoff.connected();
+
+		// Anything that wasn't acknowledged on the last connection
+		// may have been lost with it, so send it again.
+		requeue_publishes();
+
+		// Start as if the system config has changed so that we
+		// read it, subscribe and send our status.
+		ConfigItem seen{};
+		bool       configChanged = true;
+		bool       newConnection = true;
+		uint32_t   serviceMs     = MinServiceMs;
 
 		// Use the unwind error handler around our
 		// main loop
@@ -248,30 +366,91 @@ void __cheri_compartment("provider") provider_run()
 			// something goes wrong
 			while (true)
 			{
-				auto ret = update_status(configHandle, mqttHandle);
-				if (ret < 0)
+				// Only call into the broker when the version
+				// of the system config has moved on.
+				if (configChanged)
 				{
-					Debug::log("update status failed - error {}", ret);
-					break;
+					auto ret = update_status(
+					  configHandle, mqttHandle, &seen, newConnection);
+					if (ret < 0)
+					{
+						Debug::log("update status failed - error {}", ret);
+						break;
+					}
+					newConnection = false;
+				}
+
+				// Apply the config messages held since subscribing,
+				// and queue our status once it has settled.  Wake
+				// up again in time for whichever is due next.
+				Ticks serviceTicks = MS_TO_TICKS(serviceMs);
+				Ticks ingestTicks  = flush_ingest(apply_message, KeyringTopic);
+				Ticks statusTicks  = flush_status(status_topic);
+				for (Ticks due : {ingestTicks, statusTicks})
+				{
+					if ((due > 0) && (due < serviceTicks))
+					{
+						serviceTicks = due;
+					}
 				}
 
-				// process any received messages
-				ret = mqtt_run(&t, mqttHandle);
+				// Send whatever is queued that fits in the window of
+				// unacknowledged messages, without waiting for the
+				// PUBACKs.
+				flush_publishes(mqttHandle, outgoingPublishCount);
+
+				// Let the MQTT stack process anything from the
+				// broker, including keepalives and PUBACKs.
+				Timeout run{
+				  std::min<Ticks>(serviceTicks, MS_TO_TICKS(MqttRunMs))};
+				uint32_t received = messagesReceived;
+				auto     ret      = mqtt_run(&run, mqttHandle);
 				if (ret < 0)
 				{
 					Debug::log("mqtt_run failed - error {}", ret);
 					break;
 				}
 
-				// Give other threads a chance to run
-				Timeout t{MS_TO_TICKS(5)};
-				thread_sleep(&t);
+				// If there was a message there may be more queued
+				// behind it, and if a PUBACK made room in the window
+				// there are more messages to send, so go straight
+				// back to the MQTT stack.
+				if ((messagesReceived != received) || publish_window_opened())
+				{
+					serviceMs = MinServiceMs;
+					configChanged =
+					  (seen.versionFutex == nullptr) ||
+					  (seen.versionFutex->load() != seen.version);
+					continue;
+				}
+
+				// Sleep for whatever is left of the interval, or
+				// until the system config changes.  If we couldn't
+				// get the futex just try again after the interval.
+				Timeout t{serviceTicks - std::min(serviceTicks, run.elapsed)};
+				if (seen.versionFutex == nullptr)
+				{
+					thread_sleep(&t);
+					continue;
+				}
+				if (t.may_block())
+				{
+					EventWaiterSource event{seen.versionFutex, seen.version};
+					multiwaiter_wait(&t, mw, &event, 1);
+				}
+				configChanged = (seen.versionFutex->load() != seen.version);
+
+				// Poll less often while nothing is happening
+				serviceMs = configChanged
+				              ? MinServiceMs
+				              : std::min(serviceMs * 2, MaxServiceMs);
 			}
 		});
 
 		// If we got here something went wrong, so disconnect
 		// and try again
 		Debug::log("Disconecting from MQTT server");
+		t = Timeout{MS_TO_TICKS(5000)};
 		mqtt_disconnect(&t, STATIC_SEALED_VALUE(mqttTestMalloc), mqttHandle);
 	}
 }
@@ -0,0 +1,297 @@
+// Copyright Configured Things and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+#include <cstdint>
+#include <cstdlib>
+#include <debug.hh>
+#include <errno.h>
+#include <mqtt.h>
+#include <string.h>
+#include <string_view>
+#include <thread.h>
+#include <tick_macros.h>
+
+#include "publish_queue.h"
+
+// Expose debugging features unconditionally for this compartment.
+using Debug = ConditionalDebug<true, "Publish">;
+
+namespace
+{
+	/// Most messages that can be queued or in flight at once, not
+	/// counting the one in the caller's buffer
+	constexpr size_t MaxQueued = 16;
+
+	/// Longest topic for a message in the caller's buffer
+	constexpr size_t MaxBufferTopicLength = 48;
+
+	/// Time allowed to hand each message to the MQTT stack
+	constexpr uint32_t PublishTimeoutMs = 5000;
+
+	enum class SlotState : uint8_t
+	{
+		Free,
+		Queued,   // Waiting to be sent
+		InFlight, // Sent and waiting for a PUBACK
+	};
+
+	/**
+	 * A message in the queue.  For a copied message the topic and
+	 * payload are held in a single allocation, topic first.
+	 */
+	struct Slot
+	{
+		SlotState   state;
+		bool        retain;
+		uint16_t    packetId; // Set once the message is in flight
+		uint32_t    order;    // Messages are sent lowest order first
+		const char *topic;
+		size_t      topicLength;
+		const void *payload;
+		size_t      payloadLength;
+		void       *allocation; // Freed with the slot, or nullptr
+	};
+
+	/// The last slot is kept for the message in the caller's buffer
+	Slot     slots[MaxQueued + 1];
+	Slot    &bufferSlot = slots[MaxQueued];
+	char     bufferTopic[MaxBufferTopicLength];
+	uint32_t nextOrder    = 0;
+	size_t   inFlight     = 0;
+	bool     windowOpened = false;
+
+	std::string_view topic_of(const Slot &slot)
+	{
+		return {slot.topic, slot.topicLength};
+	}
+
+	void release(Slot &slot)
+	{
+		free(slot.allocation);
+		slot = {};
+	}
+
+	/**
+	 * Only the latest retained message for a topic matters, so
+	 * drop any older one that hasn't been sent yet.
+	 */
+	void drop_unsent_retained(std::string_view topic)
+	{
+		for (auto &slot : slots)
+		{
+			if ((slot.state == SlotState::Queued) && slot.retain &&
+			    (topic_of(slot) == topic))
+			{
+				Debug::log("Replacing unsent message for {}", topic);
+				release(slot);
+			}
+		}
+	}
+
+	/**
+	 * The oldest message waiting to be sent, or nullptr if there
+	 * isn't one.
+	 */
+	Slot *next_queued()
+	{
+		Slot *next = nullptr;
+		for (auto &slot : slots)
+		{
+			if ((slot.state == SlotState::Queued) &&
+			    ((next == nullptr) || (slot.order < next->order)))
+			{
+				next = &slot;
+			}
+		}
+		return next;
+	}
+
+	/**
+	 * Hand a message to the MQTT stack.  Returns the packet id
+	 * the PUBACK will carry, or a negative error.
+	 */
+	int send(MQTTConnection mqtt, Slot &slot)
+	{
+		Timeout t{MS_TO_TICKS(PublishTimeoutMs)};
+
+		// Use capabilities with only Load permission so we can be
+		// sure the MQTT stack doesn't capture a pointer to our buffer
+		CHERI::Capability roTopic{slot.topic};
+		roTopic.permissions() &= {CHERI::Permission::Load};
+		roTopic.bounds().set_inexact(slot.topicLength);
+
+		CHERI::Capability roPayload{slot.payload};
+		roPayload.permissions() &= {CHERI::Permission::Load};
+		roPayload.bounds().set_inexact(slot.payloadLength);
+
+		return mqtt_publish(&t,
+		                    mqtt,
+		                    1, // QoS 1 = delivered at least once
+		                    roTopic,
+		                    slot.topicLength,
+		                    roPayload,
+		                    slot.payloadLength,
+		                    slot.retain);
+	}
+} // namespace
+
+int queue_publish(std::string_view topic,
+                  const void      *payload,
+                  size_t           payloadLength,
+                  bool             retain)
+{
+	if (retain)
+	{
+		drop_unsent_retained(topic);
+	}
+
+	Slot *empty = nullptr;
+	for (size_t i = 0; i < MaxQueued; i++)
+	{
+		if (slots[i].state == SlotState::Free)
+		{
+			empty = &slots[i];
+			break;
+		}
+	}
+	if (empty == nullptr)
+	{
+		Debug::log("Publish queue full, dropping message for {}", topic);
+		return -EAGAIN;
+	}
+
+	auto *buffer = static_cast<char *>(malloc(topic.size() + payloadLength));
+	if (buffer == nullptr)
+	{
+		Debug::log("Failed to allocate space for message for {}", topic);
+		return -ENOMEM;
+	}
+	memcpy(buffer, topic.data(), topic.size());
+	memcpy(buffer + topic.size(), payload, payloadLength);
+
+	*empty = {SlotState::Queued,
+	          retain,
+	          0,
+	          nextOrder++,
+	          buffer,
+	          topic.size(),
+	          buffer + topic.size(),
+	          payloadLength,
+	          buffer};
+	return 0;
+}
+
+int queue_publish_buffer(std::string_view topic,
+                         const void      *payload,
+                         size_t           payloadLength,
+                         bool             retain)
+{
+	if (bufferSlot.state == SlotState::InFlight)
+	{
+		return -EBUSY;
+	}
+	if (topic.size() > sizeof(bufferTopic))
+	{
+		Debug::log("Topic {} too long to publish from a buffer", topic);
+		return -EINVAL;
+	}
+
+	// This also drops an unsent message from the buffer slot
+	if (retain)
+	{
+		drop_unsent_retained(topic);
+	}
+
+	// The topic is copied, as the caller may change it while the
+	// message is waiting, but the payload is sent from where it is
+	memcpy(bufferTopic, topic.data(), topic.size());
+	bufferSlot = {SlotState::Queued,
+	              retain,
+	              0,
+	              nextOrder++,
+	              bufferTopic,
+	              topic.size(),
+	              payload,
+	              payloadLength,
+	              nullptr};
+	return 0;
+}
+
+bool publish_buffer_busy()
+{
+	return bufferSlot.state == SlotState::InFlight;
+}
+
+void flush_publishes(MQTTConnection mqtt, size_t maxInFlight)
+{
+	while (inFlight < maxInFlight)
+	{
+		Slot *slot = next_queued();
+		if (slot == nullptr)
+		{
+			return;
+		}
+
+		int ret = send(mqtt, *slot);
+		if (ret < 0)
+		{
+			// Leave it queued and try again next time
+			Debug::log("Failed to publish to {}: error {}",
+			           topic_of(*slot),
+			           ret);
+			return;
+		}
+
+		// A packet id of 0 means there is no PUBACK to wait for
+		if (ret == 0)
+		{
+			release(*slot);
+			continue;
+		}
+		slot->state    = SlotState::InFlight;
+		slot->packetId = static_cast<uint16_t>(ret);
+		inFlight++;
+	}
+}
+
+bool publish_window_opened()
+{
+	bool opened  = windowOpened;
+	windowOpened = false;
+	return opened;
+}
+
+void requeue_publishes()
+{
+	for (auto &slot : slots)
+	{
+		if (slot.state == SlotState::InFlight)
+		{
+			slot.state    = SlotState::Queued;
+			slot.packetId = 0;
+		}
+	}
+	inFlight = 0;
+}
+
+void __cheri_callback publish_ack(uint16_t packetId, bool isReject)
+{
+	for (auto &slot : slots)
+	{
+		if ((slot.state == SlotState::InFlight) && (slot.packetId == packetId))
+		{
+			if (isReject)
+			{
+				Debug::log("Publish to {} rejected", topic_of(slot));
+			}
+			release(slot);
+			inFlight--;
+			if (next_queued() != nullptr)
+			{
+				windowOpened = true;
+			}
+			return;
+		}
+	}
+	Debug::log("Unexpected PUBACK for packet {}", packetId);
+}
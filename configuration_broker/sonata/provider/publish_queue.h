@@ -0,0 +1,44 @@
+// Copyright Configured Things and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+// Queue a message to be published with QoS 1.  The topic and payload
+// are copied, so the caller can reuse its buffers straight away.  A
+// retained message replaces any for the same topic that hasn't been
+// sent yet.  Returns 0 on success, -ENOMEM if the message can't be
+// copied, or -EAGAIN if the queue is full.
+int queue_publish(std::string_view topic,
+                  const void      *payload,
+                  size_t           payloadLength,
+                  bool             retain);
+
+// Queue a message whose payload stays in the caller's buffer, so it isn't
+// allocated or copied.  There is one slot for such a message, used for the
+// signed status.  It replaces one that hasn't been sent yet, and the buffer
+// mustn't be changed while publish_buffer_busy() returns true.  Returns 0 on
+// success, -EBUSY if the slot is in flight, or -EINVAL if the topic is too
+// long.
+int queue_publish_buffer(std::string_view topic,
+                         const void      *payload,
+                         size_t           payloadLength,
+                         bool             retain);
+
+// Returns true while the message from queue_publish_buffer() has been sent
+// and is waiting for a PUBACK, as it may need to be sent again from the
+// caller's buffer.
+bool publish_buffer_busy();
+
+// Send queued messages, oldest first, until maxInFlight of them are
+// waiting for a PUBACK.
+void flush_publishes(MQTTConnection mqtt, size_t maxInFlight);
+
+// Returns true, once, after a PUBACK has made room to send a message
+// that is waiting in the queue.
+bool publish_window_opened();
+
+// Queue the messages that were sent but not acknowledged to be sent
+// again.  Call after reconnecting, as they may have been lost along
+// with the connection.
+void requeue_publishes();
+
+// Callback for the MQTT stack when a PUBACK is received
+void __cheri_callback publish_ack(uint16_t packetId, bool isReject);
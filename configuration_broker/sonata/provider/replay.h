@@ -0,0 +1,145 @@
+// Copyright Configured Things and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string_view>
+#include <utility>
+
+/**
+ * Replay protection for signed config messages.
+ *
+ * The signer increases the counter for every message it signs with
+ * a key, and the counter is covered by the signature so it can't be
+ * changed without the message failing to verify.  The counters seen
+ * on one topic always go up, but one key signs messages for every
+ * item, so the retained messages the broker sends on subscribing can
+ * have counters that are far apart and in any order.
+ *
+ * So the last counter applied is kept for each key and item, and a
+ * message is a replay if its counter is at or below that.  This
+ * rejects a QoS 1 redelivery or a retained message we've already
+ * applied before the expensive signature check, while a retained
+ * item we haven't applied is accepted however old its counter is.
+ *
+ * A counter is only recorded once its message has been verified
+ * and accepted by the Broker, so the table can't be filled with
+ * unknown items by anyone without a key, and a message that was
+ * rate limited or failed to parse can still be applied when it is
+ * delivered again.  The state isn't
+ * persistent, so after a restart the first message for each item is
+ * checked by signature alone.
+ */
+template<size_t NumKeys>
+class ReplayGuard
+{
+	static constexpr size_t MaxItems      = 8;
+	static constexpr size_t MaxNameLength = 24;
+
+	struct Item
+	{
+		char     name[MaxNameLength];
+		size_t   nameLength;           // 0 if the entry is free
+		uint32_t lastCounter[NumKeys]; // 0 if none applied
+	};
+
+	Item items[MaxItems] = {};
+
+	const Item *find(std::string_view name) const
+	{
+		for (auto &item : items)
+		{
+			if ((item.nameLength != 0) &&
+			    (std::string_view{item.name, item.nameLength} == name))
+			{
+				return &item;
+			}
+		}
+		return nullptr;
+	}
+
+	Item *find(std::string_view name)
+	{
+		return const_cast<Item *>(std::as_const(*this).find(name));
+	}
+
+	public:
+	/**
+	 * Check if a message can be tracked, which needs space for its
+	 * item if it hasn't been seen before.
+	 */
+	bool can_track(std::string_view name) const
+	{
+		if ((name.size() == 0) || (name.size() > MaxNameLength))
+		{
+			return false;
+		}
+		if (find(name) != nullptr)
+		{
+			return true;
+		}
+		for (auto &item : items)
+		{
+			if (item.nameLength == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Check if a counter is at or below the last one applied for
+	 * the item with the key.
+	 */
+	bool is_replay(uint8_t keyId, std::string_view name, uint32_t counter) const
+	{
+		auto *item = find(name);
+		return (item != nullptr) && (counter <= item->lastCounter[keyId]);
+	}
+
+	/**
+	 * Record the counter of a message that has been verified and
+	 * applied.  The caller has checked the item can be tracked.
+	 */
+	void record(uint8_t keyId, std::string_view name, uint32_t counter)
+	{
+		Item *item = find(name);
+		if (item == nullptr)
+		{
+			for (auto &entry : items)
+			{
+				if (entry.nameLength == 0)
+				{
+					item = &entry;
+					break;
+				}
+			}
+			if ((item == nullptr) || (name.size() > MaxNameLength))
+			{
+				return;
+			}
+			*item = {};
+			memcpy(item->name, name.data(), name.size());
+			item->nameLength = name.size();
+		}
+		if (counter > item->lastCounter[keyId])
+		{
+			item->lastCounter[keyId] = counter;
+		}
+	}
+
+	/**
+	 * Start again for a key that has been replaced, as the new
+	 * signer's counters have nothing to do with the old one's.
+	 */
+	void forget_key(uint8_t keyId)
+	{
+		for (auto &item : items)
+		{
+			item.lastCounter[keyId] = 0;
+		}
+	}
+};
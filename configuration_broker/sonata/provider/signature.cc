@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <debug.hh>
+#include <string.h>
 
 void __cheri_compartment("provider") provider_run();
 
@@ -15,26 +16,183 @@ using Error = ConditionalDebug<true, "Crypto">;
 using CHERI::Capability;
 
 #include "signature.h"
-#include "../../../third_party/crypto/crypto.h"
+#include "replay.h"
 
-// Keys used for signatures - for now compiled in but
-// should be runtime supplied, such as read from the SD
-// card. 
+#include "config/include/keyring.h"
+
+// Define sealed capability that gives this compartment
+// read access to the keyring
+#include "common/config_broker/config_broker.h"
+
+#define KEYRING_CONFIG "keyring"
+DEFINE_READ_CONFIG_CAPABILITY(KEYRING_CONFIG)
+
+// Keys used for signatures.  The root config key and the status
+// keys are compiled in, other config keys are supplied at runtime
+// in the keyring.
 #include "./keys/config_pub_key.h"
 #include "./keys/status_pri_key.h"
 #include "./keys/status_pub_key.h"
 
 // Size of the header in signed messages
 #define SIGN_HEADER_BYTES hydro_sign_CONTEXTBYTES + hydro_sign_BYTES
+static_assert(SIGNATURE::HeaderBytes == SIGN_HEADER_BYTES);
+
+namespace {
+
+/**
+ * Keys for verifying signed config messages.
+ *
+ * The signing context is 8 lower case hex digits: a key id in the
+ * first two and a message counter in the other six.  Key id 0 is
+ * the root key built in above, and ids 1 to keyring::Size are the
+ * keys in the "keyring" config item, which has to be signed by the
+ * root key.  The id indexes straight into slots[], so checking a
+ * message costs the same however many signers there are.
+ *
+ * Keys from the keyring are copied into their slots the first time
+ * they are needed after each new version of the keyring, so the
+ * Broker is only called when the keyring has changed.
+ */
+constexpr size_t NumKeys = 1 + keyring::Size;
+
+struct KeySlot {
+	bool inUse;
+	uint8_t publicKey[hydro_sign_PUBLICKEYBYTES];
+};
+
+KeySlot slots[NumKeys];
+
+/// Last counter applied for each key and item (see replay.h)
+ReplayGuard<NumKeys> replayGuard;
+
+std::atomic<uint32_t> *keyringFutex = nullptr;
+uint32_t keyringVersion = 0;
+
+/**
+ * Read the key id and counter from a context.  Counters start at 1.
+ */
+bool parse_context(const char *context, uint8_t *keyId, uint32_t *counter)
+{
+	uint32_t value = 0;
+	for (size_t i = 0; i < hydro_sign_CONTEXTBYTES; i++)
+	{
+		char c = context[i];
+		uint32_t digit;
+		if (c >= '0' && c <= '9')
+		{
+			digit = c - '0';
+		}
+		else if (c >= 'a' && c <= 'f')
+		{
+			digit = c - 'a' + 10;
+		}
+		else
+		{
+			return false;
+		}
+		value = (value << 4) | digit;
+	}
+	*keyId = value >> 24;
+	*counter = value & 0xffffff;
+	return *counter != 0;
+}
+
+/**
+ * Put a key in a slot, starting its replay protection again if the
+ * key has changed
+ */
+void set_key(KeySlot *slot, const uint8_t *key)
+{
+	bool inUse = false;
+	for (size_t i = 0; i < hydro_sign_PUBLICKEYBYTES; i++)
+	{
+		inUse |= (key[i] != 0);
+	}
+
+	if ((slot->inUse != inUse) ||
+	    (memcmp(slot->publicKey, key, hydro_sign_PUBLICKEYBYTES) != 0))
+	{
+		memcpy(slot->publicKey, key, hydro_sign_PUBLICKEYBYTES);
+		slot->inUse = inUse;
+		replayGuard.forget_key(slot - slots);
+	}
+}
+
+/**
+ * Copy the keys from the current version of the keyring
+ */
+void load_keyring()
+{
+	static const uint8_t NoKey[hydro_sign_PUBLICKEYBYTES] = {};
+
+	auto item = get_config(READ_CONFIG_CAPABILITY(KEYRING_CONFIG));
+	keyringFutex = item.versionFutex;
+	keyringVersion = item.version;
+
+	// Make a fast claim so the keyring can't be freed while we copy it
+	Timeout t{5000};
+	auto *config = static_cast<keyring::Config *>(item.data);
+	if ((config != nullptr) &&
+	    (heap_claim_ephemeral(&t, config, nullptr) != 0))
+	{
+		Error::log("Failed to claim keyring");
+		config = nullptr;
+	}
+
+	const uint8_t *keys[keyring::Size] = {NoKey, NoKey, NoKey, NoKey};
+	if (config != nullptr)
+	{
+		keys[0] = config->key0;
+		keys[1] = config->key1;
+		keys[2] = config->key2;
+		keys[3] = config->key3;
+	}
+	for (size_t i = 0; i < keyring::Size; i++)
+	{
+		set_key(&slots[1 + i], keys[i]);
+	}
+	Debug::log("Loaded version {} of the keyring", keyringVersion);
+}
+
+/**
+ * Find the slot for a key id, or nullptr if there is no such key
+ */
+KeySlot *find_key(uint8_t keyId)
+{
+	if (keyId >= NumKeys)
+	{
+		return nullptr;
+	}
+
+	if (keyId == 0)
+	{
+		if (!slots[0].inUse)
+		{
+			set_key(&slots[0], config_pub_key);
+		}
+	}
+	else if ((keyringFutex == nullptr) ||
+	         (keyringFutex->load() != keyringVersion))
+	{
+		load_keyring();
+	}
+
+	return slots[keyId].inUse ? &slots[keyId] : nullptr;
+}
+
+} // namespace
 
 namespace SIGNATURE {
 
 /** 
- * Verify a signature in a payload.
+ * Verify a signature in a payload for a config item.
  *
- * Packed as Context[8] + Signature[64] + Message
+ * Packed as Context[8] + Signature[64] + Message, where the context
+ * holds the key id and message counter as 8 lower case hex digits.
  */
-Message verify_signature(const void *payload, size_t payloadLength)
+Message verify_signature(std::string_view item, const void *payload,
+               size_t payloadLength, Counter *counter, bool rootKeyOnly)
 {
 	size_t messageOffset = SIGN_HEADER_BYTES;
 	if (payloadLength <= messageOffset)
@@ -46,15 +204,41 @@ Message verify_signature(const void *payload, size_t payloadLength)
 	const uint8_t *signature = (uint8_t *)(context + hydro_sign_CONTEXTBYTES);
 	void *message = (void *)(context + messageOffset);
 	size_t messageLength = payloadLength - messageOffset;
+
+	uint8_t keyId;
+	uint32_t value;
+	if (!parse_context(context, &keyId, &value))
+	{
+		Error::log("Message has no key id and counter in its context");
+		return {nullptr, 0};
+	}
+	if (rootKeyOnly && (keyId != 0))
+	{
+		Error::log("Message must be signed with the root key");
+		return {nullptr, 0};
+	}
+
+	KeySlot *slot = find_key(keyId);
+	if (slot == nullptr)
+	{
+		Error::log("No key with id {}", keyId);
+		return {nullptr, 0};
+	}
+	if (!replayGuard.can_track(item))
+	{
+		Error::log("No space to track messages for {}", item);
+		return {nullptr, 0};
+	}
+	if (replayGuard.is_replay(keyId, item, value))
+	{
+		Debug::log("Rejecting duplicate or replayed message {}:{}", keyId, value);
+		return {nullptr, 0};
+	}
 	
-	//
-	// Stuff to look up key from context goes here
-	//
-	uint8_t *key = config_pub_key;
-	
-	if (crypto_verify_signature(signature, message, messageLength, context, key) == 0)
+	if (crypto_verify_signature(signature, message, messageLength, context, slot->publicKey) == 0)
 	{
 		Debug::log("Signature Verified");
+		*counter = {keyId, value};
 		Capability roMessage {message};
 		roMessage.permissions() &= {CHERI::Permission::Load};
 		roMessage.bounds() = messageLength;
@@ -67,38 +251,71 @@ Message verify_signature(const void *payload, size_t payloadLength)
 }
 
 /**
- * Create a signed message.
+ * Read the key id and counter from a payload's context.  The
+ * payload must also have a signature and a message to be valid.
+ */
+bool read_counter(const void *payload, size_t payloadLength, Counter *counter)
+{
+	return (payloadLength > SIGN_HEADER_BYTES) &&
+	       parse_context((const char *)payload, &counter->keyId, &counter->value);
+}
+
+/**
+ * Record the counter of a message that has been applied.  The key
+ * can't have changed since the message was verified, as the keyring
+ * is only reloaded when verifying.
+ */
+void record_applied(std::string_view item, Counter counter)
+{
+	replayGuard.record(counter.keyId, item, counter.value);
+}
+
+/**
+ * Sign a message made up of a list of segments.  The context and
+ * signature are written to the header, which the caller sends in
+ * front of the segments.
  *
  * Packed as Context[8] + Signature[64] + Message
  */
-Message sign(AllocatorCapability allocator, const char* context,
-               const char *message, size_t messageLength) {
-
-	Timeout t{100};
-	size_t s_size = SIGN_HEADER_BYTES + messageLength;
-	void *signed_message = heap_allocate(&t, allocator, s_size);
-	if (!Capability{signed_message}.is_valid())
-	{
-		Debug::log("Failed to allocate {} of heap for signed message", s_size);
-		return {nullptr, 0};
-	}
+int sign_segments(const char* context, void *header,
+               const Segment *segments, size_t numSegments) {
 
-	char *s_context = (char *)signed_message;
+	char *s_context = (char *)header;
 	uint8_t *s_signature = (uint8_t *)s_context + hydro_sign_CONTEXTBYTES;
-	char *s_message = (char *)s_signature + hydro_sign_BYTES;
 
 	strncpy(s_context, context, hydro_sign_CONTEXTBYTES);
-	strncpy(s_message, message, messageLength);
-	
-	// Stuff to look up key from context goes here
-	//
+
+	// Only status messages are signed here, always with the status key
 	uint8_t *key = status_pri_key;
 	
-	crypto_sign(s_signature, message, messageLength, context, status_pri_key);
+	int ret = crypto_sign_segments(s_signature, segments, numSegments, context, key);
+	if (ret != 0)
+	{
+		Error::log("Failed to generate signature");
+		return ret;
+	}
 	Debug::log("Signature generated");
+	return 0;
+}
+
+/**
+ * Sign a message in place.  The caller has already written the
+ * message after SIGN_HEADER_BYTES of space in the buffer.
+ *
+ * Packed as Context[8] + Signature[64] + Message
+ */
+Message sign_in_place(const char* context, void *buffer, size_t messageLength) {
+
+	size_t s_size = SIGN_HEADER_BYTES + messageLength;
+
+	Segment message = {(char *)buffer + SIGN_HEADER_BYTES, messageLength};
+	if (sign_segments(context, buffer, &message, 1) != 0)
+	{
+		return {nullptr, 0};
+	}
 	
 	// Create a read only capabilty that is bound to the size of the message
-	Capability<void>s_cap = {signed_message};
+	Capability<void>s_cap = {buffer};
 	s_cap.permissions() &= {CHERI::Permission::Load};
 	s_cap.bounds() = s_size;
 
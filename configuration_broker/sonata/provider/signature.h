@@ -3,8 +3,11 @@
 
 #include <compartment.h>
 #include <stddef.h>
+#include <string_view>
 #include <token.h>
 
+#include "../../../third_party/crypto/crypto.h"
+
 // Helper functions
 namespace SIGNATURE {
 
@@ -13,13 +16,44 @@ struct Message {
     size_t length;
 };
 
-// Verify a signature and return the embedded message 
-Message verify_signature(const void *payload, size_t payloadLength);
+// Size of the context and signature at the start of a signed message
+constexpr size_t HeaderBytes = 8 + 64;
+
+// The key id and counter from the context of a verified message
+struct Counter {
+    uint8_t keyId;
+    uint32_t value;
+};
+
+// Verify a signature on a message for a config item and return the embedded
+// message, with its key id and counter in counter.  If rootKeyOnly is set the
+// message must be signed with the root key rather than one from the keyring.
+Message verify_signature(std::string_view item, const void *payload,
+               size_t payloadLength, Counter *counter,
+               bool rootKeyOnly = false);
+
+// Read the key id and counter from the context of a signed payload, without
+// verifying it.  Returns false if the payload has no valid context.
+bool read_counter(const void *payload, size_t payloadLength, Counter *counter);
+
+// Record that a verified message has been applied, so that it and any older
+// message for the item from the same key are rejected as replays.  Messages
+// that failed to apply aren't recorded, so a redelivery can still be applied.
+void record_applied(std::string_view item, Counter counter);
+
+// A part of a message to be signed
+using Segment = CryptoSegment;
+
+// Sign the concatenation of a list of segments, writing the context and
+// signature into the HeaderBytes at header.  The segments don't need to be
+// copied together first.  Returns 0 on success.
+int sign_segments(const char *context, void *header,
+               const Segment *segments, size_t numSegments);
 
-// Sign a message and return new message which includes a capabilty to a heap allocated buffer
-// containing the message and the signature
-Message sign(AllocatorCapability allocator, const char* context,
-               const char *message, size_t messageLength);
+// Sign a message already held in buffer after HeaderBytes of space, by
+// writing the context and signature into that space.  Returns a read only
+// capabilty to the signed message in buffer.
+Message sign_in_place(const char *context, void *buffer, size_t messageLength);
 
 } // namespace CRYPTO
 
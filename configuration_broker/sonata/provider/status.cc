@@ -6,105 +6,152 @@
 #include <debug.hh>
 #include <mqtt.h>
 #include <thread.h>
+#include <tick_macros.h>
 #include <token.h>
 
 #include "config/include/system_config.h"
 
+#include "publish_queue.h"
 #include "signature.h"
 
 // Expose debugging features unconditionally for this compartment.
 using Debug = ConditionalDebug<true, "Status">;
 
-// Publish a string to the status topic
-void publish(MQTTConnection mqtt,
-             std::string topic,
-             void       *status,
-             size_t      statusLength,
-             bool        retain)
+namespace
 {
-	Timeout t{MS_TO_TICKS(5000)};
-
-	// Use capabilities with only Load
-	// permission so we can be sure the MQTT stack
-	// doesn't capture a pointer to our buffer
-	CHERI::Capability roTopic{topic.data()};
-	roTopic.permissions() &= {CHERI::Permission::Load};
-	roTopic.bounds().set_inexact(topic.size());
-
-	CHERI::Capability roStatus{status};
-	roStatus.permissions() &= {CHERI::Permission::Load};
-	roStatus.bounds().set_inexact(statusLength);
-
-	auto ret = mqtt_publish(&t,
-	                        mqtt,
-	                        1, // QoS 1 = delivered at least once
-	                        roTopic,
-	                        topic.size(),
-	                        roStatus,
-	                        statusLength,
-	                        retain);
+	/// Space for the JSON status
+	constexpr size_t StatusMaxLength = 100;
 
+	/// Time to wait for the switches to settle, so that a burst of
+	/// changes is published as a single signed status
+	constexpr uint32_t StatusDebounceMs = 250;
+
+	/// Number of switches reported in the status
+	constexpr size_t NumSwitches = 8;
+
+	/**
+	 * Buffer for the signed status message, reused for each
+	 * publish.  The status is formatted straight into the message
+	 * part, signed in place and published from here, so there is
+	 * no allocation or copy per status.  It can't be changed while
+	 * the last status is waiting for a PUBACK.
+	 */
+	char signedStatus[SIGNATURE::HeaderBytes + StatusMaxLength];
+	char *const statusJson = signedStatus + SIGNATURE::HeaderBytes;
+
+	bool     statusSwitches[NumSwitches];
+	bool     statusPending = false;
+	uint64_t statusDue     = 0; // System tick to publish at
+
+	uint64_t now()
+	{
+		auto system_tick = thread_systemtick_get();
+		return (static_cast<uint64_t>(system_tick.hi) << 32) + system_tick.lo;
+	}
+} // namespace
+
+// Queue a string to be published to the status topic
+void publish(const std::string &topic,
+             const void        *status,
+             size_t             statusLength,
+             bool               retain)
+{
+	auto ret = queue_publish(
+	  {topic.data(), topic.size()}, status, statusLength, retain);
 	if (ret < 0)
 	{
-		Debug::log("Failed to send status: error {}", ret);
+		Debug::log("Failed to queue status: error {}", ret);
 	}
 }
 
-void send_status(MQTTConnection mqtt, std::string topic, systemConfig::Config *config)
+void queue_status(systemConfig::Config *config)
 {
-	Debug::log("Sending Status");
-	char status[100];
+	// This replaces any status still waiting to be published.  The
+	// JSON is only formatted when it is published, as the last one
+	// may still be in flight from the buffer.
+	for (size_t i = 0; i < NumSwitches; i++)
+	{
+		statusSwitches[i] = config->switches[i];
+	}
 
-	static uint8_t prev = 0;
-	static bool    init = false;
+	// The first change opens the debounce window, and any more
+	// changes before it closes are published along with it.
+	if (!statusPending)
+	{
+		statusDue     = now() + MS_TO_TICKS(StatusDebounceMs);
+		statusPending = true;
+	}
+}
 
-	// Convert the switches to a value
-	uint8_t switchesValue = 0;
-	for (auto i = 0; i < 8; i++)
+Ticks flush_status(const std::string &topic)
+{
+	if (!statusPending)
 	{
-		if (config->switches[i])
-		{
-			switchesValue += 1 << i;
-		}
+		return 0;
 	}
 
+	uint64_t tick = now();
+	if (tick < statusDue)
+	{
+		return static_cast<Ticks>(statusDue - tick);
+	}
+
+	// Wait for the last status to be acknowledged before reusing
+	// its buffer
+	if (publish_buffer_busy())
+	{
+		return MS_TO_TICKS(StatusDebounceMs);
+	}
+
+	Debug::log("Sending Status");
+	statusPending = false;
+
 	// Create the JSON representation
-	snprintf(
-	  status,
-	  sizeof(status) / sizeof(status[0]),
+	int length = snprintf(
+	  statusJson,
+	  StatusMaxLength,
 	  "{\"Status\":\"On\",\"switches\": [%d, %d, %d, %d, %d, %d, %d, %d]}",
-	  config->switches[0] ? 1 : 0,
-	  config->switches[1] ? 1 : 0,
-	  config->switches[2] ? 1 : 0,
-	  config->switches[3] ? 1 : 0,
-	  config->switches[4] ? 1 : 0,
-	  config->switches[5] ? 1 : 0,
-	  config->switches[6] ? 1 : 0,
-	  config->switches[7] ? 1 : 0);
-
-	// Get a signed version
-	size_t statusLength = strlen(status);
-	auto   signed_message =
-	  SIGNATURE::sign(MALLOC_CAPABILITY, "StatusCX", status, statusLength);
-	if (signed_message.data.is_valid())
+	  statusSwitches[0] ? 1 : 0,
+	  statusSwitches[1] ? 1 : 0,
+	  statusSwitches[2] ? 1 : 0,
+	  statusSwitches[3] ? 1 : 0,
+	  statusSwitches[4] ? 1 : 0,
+	  statusSwitches[5] ? 1 : 0,
+	  statusSwitches[6] ? 1 : 0,
+	  statusSwitches[7] ? 1 : 0);
+	if ((length < 0) || (static_cast<size_t>(length) >= StatusMaxLength))
 	{
-		Debug::log("Publishing signed message {}", signed_message.data);
-		publish(mqtt, topic, signed_message.data, signed_message.length, true);
-		heap_free(MALLOC_CAPABILITY, signed_message.data);
+		Debug::log("Status doesn't fit in {} bytes", StatusMaxLength);
+		return 0;
 	}
-	else
+
+	// Sign the status where it is
+	auto signed_message =
+	  SIGNATURE::sign_in_place("StatusCX", signedStatus, length);
+	if (!signed_message.data.is_valid())
 	{
-		Debug::log("Failed to sign message");
+		Debug::log("Failed to sign status");
+		return 0;
 	}
+
+	Debug::log("Publishing signed message {}", signed_message.data);
+	auto ret = queue_publish_buffer({topic.data(), topic.size()},
+	                                signed_message.data,
+	                                signed_message.length,
+	                                true);
+	if (ret < 0)
+	{
+		Debug::log("Failed to queue status: error {}", ret);
+	}
+
+	return 0;
 }
 
-void clear_status(MQTTConnection mqtt, std::string topic)
+void clear_status(const std::string &topic)
 {
 	// Clear the peristent status message by
 	// pubishing a zero length message
-	char              status;
-	CHERI::Capability statusCap = {&status};
-	statusCap.bounds()          = 0;
-	Debug::log("clear status with {}", statusCap);
-	publish(mqtt, topic, statusCap, 0, true);
+	char status;
+	Debug::log("clear status on {}", topic.c_str());
+	publish(topic, &status, 0, true);
 }
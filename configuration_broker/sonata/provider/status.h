@@ -1,8 +1,14 @@
 // Copyright Configured Things and CHERIoT Contributors.
 // SPDX-License-Identifier: MIT
 
-// Publish status based on the System config
-void send_status(MQTTConnection mqtt, std::string topic, systemConfig::Config *config);
+// Queue a status update based on the System config.  It is
+// published by flush_status() once the switches have settled.
+void queue_status(systemConfig::Config *config);
+
+// Pass any queued status that has settled to the publish queue.
+// Returns the number of ticks until the queued status will be due,
+// or 0 if there is nothing left waiting.
+Ticks flush_status(const std::string &topic);
 
 // Clear the status
-void clear_status(MQTTConnection mqtt, std::string topic);
+void clear_status(const std::string &topic);
@@ -2,6 +2,14 @@
 -- SPDX-License-Identifier: MIT
 
 
+option("mqtt-broker")
+    set_default("test.mosquitto.org")
+    set_description("Host name of the MQTT broker, for example a local broker for testing")
+
+option("mqtt-port")
+    set_default("8883")
+    set_description("TLS port of the MQTT broker")
+
 -- Provider Compartment
 compartment("provider")
 
@@ -15,11 +23,16 @@ compartment("provider")
     add_files("mqtt.cc")
     add_files("config.cc")
     add_files("status.cc")
+    add_files("ingest.cc")
+    add_files("publish_queue.cc")
     add_files("signature.cc")
 
     on_load(function(target)
         target:add('options', "IPv6")
         local IPv6 = get_config("IPv6")
         target:add("defines", "CHERIOT_RTOS_OPTION_IPv6=" .. tostring(IPv6))
+        target:add('options', "mqtt-broker", "mqtt-port")
+        target:add("defines", "MQTT_BROKER_HOST=\"" .. tostring(get_config("mqtt-broker")) .. "\"")
+        target:add("defines", "MQTT_BROKER_PORT=" .. tostring(get_config("mqtt-port")))
     end)
 
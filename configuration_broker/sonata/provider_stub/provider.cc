@@ -15,6 +15,7 @@ using Debug = ConditionalDebug<true, "Provider">;
  * items this compartment is allowed to update
  */
 #include "common/config_broker/config_broker.h"
+#include "common/config_broker/config_item_map.h"
 #define SYSTEM_CONFIG "system"
 DEFINE_WRITE_CONFIG_CAPABILITY(SYSTEM_CONFIG)
 
@@ -28,34 +29,17 @@ namespace
 {
 
 	/**
-	 * Map of Config names to capabilites
+	 * Map of Config names to capabilites, built at compile time
+	 * so that each name is found with an exact match in constant
+	 * time.
 	 */
-	struct Config
-	{
-		const char *name;
-		SObj        cap; // Sealed Write Capability
+	constexpr ConfigItemName ConfigItems[] = {
+	  CONFIG_ITEM_NAME("rgbled", RGB_LED_CONFIG),
+	  CONFIG_ITEM_NAME("userled", USER_LED_CONFIG),
+	  CONFIG_ITEM_NAME("system", SYSTEM_CONFIG),
 	};
 
-	// We can't use the macros at the file level to statically
-	// initialise configItemMap, so do it via a function
-	Config configItemMap[3];
-	void   set_up_name_map()
-	{
-		static bool init = false;
-		if (!init)
-		{
-			configItemMap[0].name = "rgbled";
-			configItemMap[0].cap  = WRITE_CONFIG_CAPABILITY(RGB_LED_CONFIG);
-
-			configItemMap[1].name = "userled";
-			configItemMap[1].cap  = WRITE_CONFIG_CAPABILITY(USER_LED_CONFIG);
-
-			configItemMap[2].name = "system";
-			configItemMap[2].cap  = WRITE_CONFIG_CAPABILITY(SYSTEM_CONFIG);
-
-			init = true;
-		}
-	}
+	constexpr ConfigItemMap itemMap{ConfigItems};
 
 } // namespace
 
@@ -72,31 +56,22 @@ int updateConfig(const char *name,
 	std::string_view svJson((char *)json, jsonLength);
 	Debug::log("thread {} got {} on {}", thread_id_get(), svName, svJson);
 
-	// Initalise the name map
-	set_up_name_map();
+	int res = -1;
 
-	bool found = false;
-	int  res   = -1;
-
-	// Use the configItemMap to work out which value the
+	// Use the itemMap to work out which value the
 	// message is for.
-	for (auto t : configItemMap)
+	auto *item = itemMap.find(name, nameLength);
+	if (item != nullptr)
 	{
-		if (strncmp(t.name, name, nameLength) == 0)
+		auto cap = item->capability();
+		res      = set_config(cap, (const char *)json, jsonLength);
+		if (res < 0)
 		{
-			found = true;
-			res   = set_config(t.cap, (const char *)json, jsonLength);
-			if (res < 0)
-			{
-				Debug::log("thread {} Failed to set value for {}",
-				           thread_id_get(),
-				           t.cap);
-			}
-			break;
+			Debug::log(
+			  "thread {} Failed to set value for {}", thread_id_get(), cap);
 		}
 	}
-
-	if (!found)
+	else
 	{
 		Debug::log(
 		  "thread {} Unknown config item name {}", thread_id_get(), svName);
@@ -14,12 +14,18 @@ includes(path.join(sdkdir, "lib/freestanding"),
 option("board")
     set_default("sonata-1.1")
 
+option("combined_parsers")
+    set_default(false)
+    set_description("Build all of the parsers into a single sandbox compartment")
+    add_defines("COMBINED_PARSERS")
+
 -- network stack
 includes(path.join(sdkdir, "lib"))
 includes("../../network-stack/lib")
 
 -- Common libraries and compartments
 includes("../../third_party/json_parser")
+includes("../../third_party/cbor_parser")
 includes("../../third_party/crypto")
 includes("../common/config_broker") 
 includes("../common/config_consumer")
@@ -33,10 +39,23 @@ includes("system_config")
 -- MQTT Client to provide configurtaion
 includes("provider")
 
--- Configuration JSON parser sandboxes
-includes("../config/parsers/rgb_led")
-includes("../config/parsers/user_led")
-includes("../config/parsers/system_config")
+-- Configuration JSON parser sandboxes, either one per item
+-- or all in a single compartment
+if has_config("combined_parsers") then
+    compartment("parsers")
+        set_default(false)
+        add_includedirs("..")
+        add_options("combined_parsers")
+        add_files("../config/parsers/rgb_led/parser.cc")
+        add_files("../config/parsers/user_led/parser.cc")
+        add_files("../config/parsers/system_config/parser.cc")
+        add_files("../config/parsers/keyring/parser.cc")
+else
+    includes("../config/parsers/rgb_led")
+    includes("../config/parsers/user_led")
+    includes("../config/parsers/system_config")
+    includes("../config/parsers/keyring")
+end
 
 -- Consumers
 includes("consumers")
@@ -47,6 +66,7 @@ firmware("config-broker-sonata")
 
     -- libraries
     add_deps("json_parser")
+    add_deps("cbor_parser")
     add_deps("crypto")
     add_deps("config_consumer")
 
@@ -60,9 +80,14 @@ firmware("config-broker-sonata")
 
     add_deps("config_broker")
 
-    add_deps("parser_system_config")
-    add_deps("parser_rgb_led")
-    add_deps("parser_user_led")
+    if has_config("combined_parsers") then
+        add_deps("parsers")
+    else
+        add_deps("parser_system_config")
+        add_deps("parser_keyring")
+        add_deps("parser_rgb_led")
+        add_deps("parser_user_led")
+    end
     
     add_deps("consumers")
     
@@ -0,0 +1,429 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+
+#include "cbor_parser.h"
+#include <string.h>
+
+namespace cborParser
+{
+
+	namespace
+	{
+		constexpr uint8_t MajorUnsigned = 0;
+		constexpr uint8_t MajorNegative = 1;
+		constexpr uint8_t MajorBytes    = 2;
+		constexpr uint8_t MajorText     = 3;
+		constexpr uint8_t MajorArray    = 4;
+		constexpr uint8_t MajorMap      = 5;
+		constexpr uint8_t MajorSimple   = 7;
+
+		constexpr uint8_t SimpleFalse = 20;
+		constexpr uint8_t SimpleTrue  = 21;
+		constexpr uint8_t SimpleNull  = 22;
+
+		/**
+		 * The initial byte and argument of an item.
+		 */
+		struct Head
+		{
+			uint8_t  major;
+			uint64_t argument;
+		};
+
+		/**
+		 * Read the head of the item at buf[*i].  For strings the content
+		 * must fit in the buffer, and for arrays and maps there must be
+		 * at least one byte left for each item they contain, which bounds
+		 * any iteration over them by the size of the buffer.
+		 */
+		Status read_head(const uint8_t *buf, size_t *i, size_t max, Head *head)
+		{
+			if (*i >= max)
+			{
+				return Status::Partial;
+			}
+
+			uint8_t initial = buf[(*i)++];
+			uint8_t info    = initial & 0x1FU;
+			head->major     = initial >> 5;
+
+			size_t extra = 0;
+			if (info < 24)
+			{
+				head->argument = info;
+			}
+			else if (info <= 27)
+			{
+				extra = size_t{1} << (info - 24);
+			}
+			else
+			{
+				// Reserved, or an indefinite length
+				return Status::IllegalDocument;
+			}
+
+			if (max - *i < extra)
+			{
+				return Status::Partial;
+			}
+
+			if (extra > 0)
+			{
+				head->argument = 0;
+				for (size_t j = 0; j < extra; j++)
+				{
+					head->argument = (head->argument << 8) | buf[(*i)++];
+				}
+			}
+
+			uint64_t remaining = max - *i;
+			switch (head->major)
+			{
+				case MajorUnsigned:
+				case MajorNegative:
+					return Status::Success;
+
+				case MajorBytes:
+				case MajorText:
+				case MajorArray:
+					return (head->argument <= remaining) ? Status::Success
+					                                     : Status::Partial;
+
+				case MajorMap:
+					return (head->argument <= remaining / 2) ? Status::Success
+					                                         : Status::Partial;
+
+				case MajorSimple:
+					return ((extra == 0) && (head->argument >= SimpleFalse) &&
+					        (head->argument <= SimpleNull))
+					         ? Status::Success
+					         : Status::IllegalDocument;
+
+				default:
+					// Tags
+					return Status::IllegalDocument;
+			}
+		}
+
+		/**
+		 * Skip the item at buf[*i].  As items have a definite length
+		 * it's enough to count how many are still to be read, so
+		 * nesting needs no stack.
+		 */
+		Status skip_item(const uint8_t *buf, size_t *i, size_t max)
+		{
+			uint64_t pending = 1;
+			while (pending > 0)
+			{
+				Head   head;
+				Status ret = read_head(buf, i, max, &head);
+				if (ret != Status::Success)
+				{
+					return ret;
+				}
+				pending--;
+
+				switch (head.major)
+				{
+					case MajorBytes:
+					case MajorText:
+						*i += head.argument;
+						break;
+					case MajorArray:
+						pending += head.argument;
+						break;
+					case MajorMap:
+						pending += 2 * head.argument;
+						break;
+					default:
+						break;
+				}
+
+				// Every pending item needs at least one byte
+				if (pending > max - *i)
+				{
+					return Status::Partial;
+				}
+			}
+			return Status::Success;
+		}
+
+		/**
+		 * Match a key against the next part of each candidate query,
+		 * as for JSON_ValidateAndFind() in coreJSON.
+		 */
+		void match_key(const uint8_t *key,
+		               size_t         keyLength,
+		               const Query   *queries,
+		               uint32_t       candidates,
+		               size_t         prefixLength,
+		               uint32_t      *outComplete,
+		               uint32_t      *outPartial)
+		{
+			*outComplete = 0;
+			*outPartial  = 0;
+
+			// A key containing a separator can't match a single part
+			if (memchr(key, '.', keyLength) != nullptr)
+			{
+				return;
+			}
+
+			for (size_t i = 0; candidates != 0; i++)
+			{
+				uint32_t bit = 1U << i;
+				if ((candidates & bit) == 0)
+				{
+					continue;
+				}
+				candidates &= ~bit;
+
+				auto  &q   = queries[i];
+				size_t end = prefixLength + keyLength;
+				if ((q.queryLength < end) ||
+				    (memcmp(q.query + prefixLength, key, keyLength) != 0))
+				{
+					continue;
+				}
+
+				if (q.queryLength == end)
+				{
+					*outComplete |= bit;
+				}
+				else if (q.query[end] == '.')
+				{
+					*outPartial |= bit;
+				}
+			}
+		}
+
+		/**
+		 * Record the value of the item at buf[start] for each query
+		 * which ends at it and has not already been found.
+		 */
+		void record_value(const uint8_t *buf,
+		                  size_t         start,
+		                  size_t         end,
+		                  const Head    &head,
+		                  size_t         contentStart,
+		                  Query         *queries,
+		                  uint32_t       complete)
+		{
+			Type type;
+			switch (head.major)
+			{
+				case MajorUnsigned:
+					type = Type::Unsigned;
+					break;
+				case MajorNegative:
+					type = Type::Negative;
+					break;
+				case MajorBytes:
+					type = Type::Bytes;
+					break;
+				case MajorText:
+					type = Type::Text;
+					break;
+				case MajorArray:
+					type = Type::Array;
+					break;
+				case MajorMap:
+					type = Type::Map;
+					break;
+				default:
+					type = (head.argument == SimpleFalse) ? Type::False
+					       : (head.argument == SimpleTrue) ? Type::True
+					                                       : Type::Null;
+					break;
+			}
+
+			bool isString = (type == Type::Bytes) || (type == Type::Text);
+			for (size_t i = 0; complete != 0; i++)
+			{
+				uint32_t bit = 1U << i;
+				if ((complete & bit) == 0)
+				{
+					continue;
+				}
+				complete &= ~bit;
+
+				auto &q = queries[i];
+				if (q.type != Type::Invalid)
+				{
+					continue;
+				}
+				q.type        = type;
+				q.integer     = head.argument;
+				q.value       = isString ? &buf[contentStart] : &buf[start];
+				q.valueLength = isString ? head.argument : end - start;
+			}
+		}
+
+		Status find_in_map(const uint8_t *buf,
+		                   size_t        *i,
+		                   size_t         max,
+		                   uint64_t       entries,
+		                   Query         *queries,
+		                   uint32_t       candidates,
+		                   size_t         prefixLength);
+
+		/**
+		 * Read the value at buf[*i] for a key that matched some
+		 * queries, recording it for those that end here and walking
+		 * it if it is a map on the path to the others.
+		 */
+		Status find_in_value(const uint8_t *buf,
+		                     size_t        *i,
+		                     size_t         max,
+		                     Query         *queries,
+		                     uint32_t       complete,
+		                     uint32_t       partial,
+		                     size_t         prefixLength)
+		{
+			size_t start = *i;
+			Head   head;
+			Status ret = read_head(buf, i, max, &head);
+			if (ret != Status::Success)
+			{
+				return ret;
+			}
+
+			size_t contentStart = *i;
+			if ((head.major == MajorMap) && (partial != 0))
+			{
+				ret = find_in_map(
+				  buf, i, max, head.argument, queries, partial, prefixLength);
+			}
+			else
+			{
+				*i  = start;
+				ret = skip_item(buf, i, max);
+			}
+
+			if (ret == Status::Success)
+			{
+				record_value(
+				  buf, start, *i, head, contentStart, queries, complete);
+			}
+			return ret;
+		}
+
+		/**
+		 * Walk the entries of a map whose head has just been read,
+		 * recording the values of any queries found in it.  Only maps
+		 * on the path to a query are walked here, so the recursion is
+		 * bounded by the depth of the queries.
+		 */
+		Status find_in_map(const uint8_t *buf,
+		                   size_t        *i,
+		                   size_t         max,
+		                   uint64_t       entries,
+		                   Query         *queries,
+		                   uint32_t       candidates,
+		                   size_t         prefixLength)
+		{
+			for (uint64_t e = 0; e < entries; e++)
+			{
+				Head   key;
+				Status ret = read_head(buf, i, max, &key);
+				if (ret != Status::Success)
+				{
+					return ret;
+				}
+				if (key.major != MajorText)
+				{
+					return Status::IllegalDocument;
+				}
+				const uint8_t *keyData = &buf[*i];
+				*i += key.argument;
+
+				uint32_t complete;
+				uint32_t partial;
+				match_key(keyData,
+				          key.argument,
+				          queries,
+				          candidates,
+				          prefixLength,
+				          &complete,
+				          &partial);
+
+				if ((complete | partial) == 0)
+				{
+					ret = skip_item(buf, i, max);
+				}
+				else
+				{
+					ret = find_in_value(buf,
+					                    i,
+					                    max,
+					                    queries,
+					                    complete,
+					                    partial,
+					                    prefixLength + key.argument + 1);
+				}
+
+				if (ret != Status::Success)
+				{
+					return ret;
+				}
+			}
+			return Status::Success;
+		}
+
+	} // namespace
+
+	Status __cheri_libcall validate_and_find(const uint8_t *buf,
+	                                         size_t         max,
+	                                         Query         *queries,
+	                                         size_t         numQueries)
+	{
+		if ((buf == nullptr) || (max == 0) || (numQueries > 32) ||
+		    ((queries == nullptr) && (numQueries > 0)))
+		{
+			return Status::BadParameter;
+		}
+
+		for (size_t q = 0; q < numQueries; q++)
+		{
+			if ((queries[q].query == nullptr) || (queries[q].queryLength == 0))
+			{
+				return Status::BadParameter;
+			}
+			queries[q].type        = Type::Invalid;
+			queries[q].value       = nullptr;
+			queries[q].valueLength = 0;
+			queries[q].integer     = 0;
+		}
+
+		size_t i   = 0;
+		Status ret = Status::Success;
+		if (is_map(buf, max))
+		{
+			Head head;
+			ret = read_head(buf, &i, max, &head);
+			if (ret == Status::Success)
+			{
+				ret = find_in_map(
+				  buf,
+				  &i,
+				  max,
+				  head.argument,
+				  queries,
+				  (numQueries == 32) ? UINT32_MAX : ((1U << numQueries) - 1),
+				  0);
+			}
+		}
+		else
+		{
+			ret = skip_item(buf, &i, max);
+		}
+
+		if ((ret == Status::Success) && (i != max))
+		{
+			ret = Status::IllegalDocument;
+		}
+
+		return ret;
+	}
+
+} // namespace cborParser
@@ -0,0 +1,76 @@
+// Copyright Configured Things Ltd and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// A minimal CBOR (RFC 8949) decoder for configuration data, as a
+// compact alternative to JSON.  It supports the subset of CBOR that
+// maps onto JSON: definite length maps with text string keys, arrays,
+// integers, text and byte strings, and the simple values false, true
+// and null.  Floating point values, tags and indefinite length items
+// are rejected.
+
+#include <cdefs.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace cborParser
+{
+
+	enum class Status : uint8_t
+	{
+		Success,         // Document is valid and complete
+		Partial,         // Document is valid so far but incomplete
+		IllegalDocument, // Document is invalid or uses unsupported items
+		BadParameter,    // Empty buffer, query, or too many queries
+	};
+
+	enum class Type : uint8_t
+	{
+		Invalid,  // Not found
+		Unsigned, // Value is integer
+		Negative, // Value is -1 - integer
+		Bytes,
+		Text,
+		Array,
+		Map,
+		False,
+		True,
+		Null,
+	};
+
+	/**
+	 * A key path to find, and the value found for it.
+	 */
+	struct Query
+	{
+		const char    *query;       // Map keys separated by '.'
+		size_t         queryLength; // Length of the query
+		Type           type;        // Type of the value, Invalid if not found
+		const uint8_t *value;       // String content, or the encoded item
+		size_t         valueLength; // Length of value
+		uint64_t       integer;     // Magnitude of an integer
+	};
+
+	/**
+	 * Check if the first byte of a buffer is the start of a CBOR
+	 * map, which can't be the start of a JSON document, so parsers
+	 * can accept either encoding.
+	 */
+	inline bool is_map(const void *buf, size_t max)
+	{
+		return (max > 0) &&
+		       ((*static_cast<const uint8_t *>(buf) & 0xE0U) == 0xA0U);
+	}
+
+	/**
+	 * Validate that a buffer holds exactly one CBOR item and find
+	 * the values of a set of key paths in the same pass.  If a path
+	 * occurs more than once the first value is used.  At most 32
+	 * queries are supported.
+	 */
+	Status __cheri_libcall validate_and_find(const uint8_t *buf,
+	                                         size_t         max,
+	                                         Query         *queries,
+	                                         size_t         numQueries);
+
+} // namespace cborParser
@@ -0,0 +1,7 @@
+-- Copyright Configured Things Ltd and CHERIoT Contributors.
+-- SPDX-License-Identifier: MIT
+
+-- library for CBOR parser
+library("cbor_parser")
+    set_default(false)
+    add_files("cbor_parser.cc")
@@ -30,6 +30,29 @@ int __cheri_compartment("crypto") crypto_sign(
     return hydro_sign_create(signature, message, messageLength, context, secretKey);
 }
 
+/** 
+ * Create a signature over a list of segments using the incremental
+ * signing functions, which produce the same signature as signing the
+ * segments concatenated in one buffer.
+*/
+int __cheri_compartment("crypto") crypto_sign_segments(
+                    uint8_t signature[hydro_sign_BYTES], 
+                    const CryptoSegment *segments, 
+                    size_t numSegments,
+                    const char    context[hydro_sign_CONTEXTBYTES],
+                    const uint8_t secretKey[hydro_sign_SECRETKEYBYTES]) {
+
+    hydro_sign_state state;
+    int ret = hydro_sign_init(&state, context);
+    for (size_t i = 0; (ret == 0) && (i < numSegments); i++) {
+        ret = hydro_sign_update(&state, segments[i].data, segments[i].length);
+    }
+    if (ret == 0) {
+        ret = hydro_sign_final_create(&state, signature, secretKey);
+    }
+    return ret;
+}
+
 /** 
  * Verify a signature in a payload.
  *
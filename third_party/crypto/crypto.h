@@ -27,6 +27,21 @@ int __cheri_compartment("crypto") crypto_sign(
                     const char    context[hydro_sign_CONTEXTBYTES],
                     const uint8_t secretKey[hydro_sign_SECRETKEYBYTES]);
 
+// A part of a message to be signed
+struct CryptoSegment {
+    const void *data;
+    size_t      length;
+};
+
+// Sign the concatenation of a list of segments, without them
+// having to be copied into one buffer.
+int __cheri_compartment("crypto") crypto_sign_segments(
+                    uint8_t signature[hydro_sign_BYTES], 
+                    const CryptoSegment *segments, 
+                    size_t numSegments,
+                    const char    context[hydro_sign_CONTEXTBYTES],
+                    const uint8_t secretKey[hydro_sign_SECRETKEYBYTES]);
+
 int __cheri_compartment("crypto") crypto_verify_signature(
                     const uint8_t signature[hydro_sign_BYTES],
                     const void *message, 
@@ -37,6 +37,7 @@
 #include <limits.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 /** @cond DO_NOT_DOCUMENT */
 
@@ -66,6 +67,78 @@ typedef union
 #define isSquareOpen_(x) ((x) == '[')
 #define isSquareClose_(x) ((x) == ']')
 
+/*
+ * Word at a time scanning.
+ *
+ * The scanners below test four bytes per iteration by treating an
+ * aligned word as a vector of bytes.  Each test produces a word with
+ * the high bit of each byte set where that byte matches, so a zero
+ * result means the whole word can be skipped and otherwise the first
+ * match is found from the position of the lowest set bit.  Words are
+ * only loaded when they are aligned and lie entirely within the
+ * buffer, so this never reads beyond the bounds of buf.
+ */
+#define ONES_ (0x01010101U)
+#define HIGHS_ (0x80808080U)
+#define LOWS_ (0x7F7F7F7FU)
+
+/**
+ * @brief Load the aligned word at buf[i], if it is within the buffer.
+ *
+ * @return true if a word was loaded;
+ * false otherwise.
+ */
+static bool loadWord(const char *buf, size_t i, size_t max, uint32_t *outWord)
+{
+	bool ret = false;
+
+	if (((max - i) >= sizeof(uint32_t)) &&
+	    ((((uintptr_t)&buf[i]) & (sizeof(uint32_t) - 1U)) == 0U))
+	{
+		(void)memcpy(outWord,
+		             __builtin_assume_aligned(&buf[i], sizeof(uint32_t)),
+		             sizeof(uint32_t));
+		ret = true;
+	}
+
+	return ret;
+}
+
+/**
+ * @brief Flag the bytes of a word which are equal to c.
+ *
+ * Adding 0x7F to the low seven bits of a byte can't carry into the
+ * next byte, so unlike the usual "has zero byte" test every flag
+ * is exact.
+ */
+static uint32_t equalBytes(uint32_t w, char c)
+{
+	uint32_t x = w ^ (ONES_ * (uint8_t)c);
+
+	return ~(((x & LOWS_) + LOWS_) | x) & HIGHS_;
+}
+
+/**
+ * @brief Flag the bytes of a word which are less than 0x20, or not
+ * ASCII.
+ */
+static uint32_t controlOrHighBytes(uint32_t w)
+{
+	return (~((w & LOWS_) + (ONES_ * 0x60U)) | w) & HIGHS_;
+}
+
+/**
+ * @brief Index of the first flagged byte in a non-zero set of flags.
+ */
+static size_t firstFlagged(uint32_t flags)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	return (size_t)__builtin_clz(flags) >> 3U;
+#else
+	return (size_t)__builtin_ctz(flags) >> 3U;
+#endif
+}
+
 /**
  * @brief Advance buffer index beyond whitespace.
  *
@@ -75,15 +148,36 @@ typedef union
  */
 static void skipSpace(const char *buf, size_t *start, size_t max)
 {
-	size_t i = 0U;
+	size_t   i = 0U;
+	uint32_t w, other;
 
 	coreJSON_ASSERT((buf != NULL) && (start != NULL) && (max > 0U));
 
-	for (i = *start; i < max; i++)
+	i = *start;
+
+	/* Most calls find no whitespace, so check the first byte on its
+	 * own.  Indentation and line breaks are runs of spaces, tabs, CR
+	 * and LF, which are skipped a word at a time up to the first byte
+	 * that is anything else. */
+	while ((i < max) && isspace_(buf[i]))
 	{
-		if (!isspace_(buf[i]))
+		if (loadWord(buf, i, max, &w) == true)
 		{
-			break;
+			other = ~(equalBytes(w, ' ') | equalBytes(w, '\t') |
+			          equalBytes(w, '\n') | equalBytes(w, '\r')) &
+			        HIGHS_;
+
+			if (other != 0U)
+			{
+				i += firstFlagged(other);
+				break;
+			}
+
+			i += sizeof(uint32_t);
+		}
+		else
+		{
+			i++;
 		}
 	}
 
@@ -502,8 +596,9 @@ static bool skipEscape(const char *buf, size_t *start, size_t max)
  */
 static bool skipString(const char *buf, size_t *start, size_t max)
 {
-	bool   ret = false;
-	size_t i   = 0;
+	bool     ret = false;
+	size_t   i   = 0;
+	uint32_t w, special;
 
 	coreJSON_ASSERT((buf != NULL) && (start != NULL) && (max > 0U));
 
@@ -515,6 +610,23 @@ static bool skipString(const char *buf, size_t *start, size_t max)
 
 		while (i < max)
 		{
+			/* Skip whole words of plain ASCII, which is most of a
+			 * typical string, and stop at the first byte which needs
+			 * to be looked at individually. */
+			if (loadWord(buf, i, max, &w) == true)
+			{
+				special = equalBytes(w, '"') | equalBytes(w, '\\') |
+				          controlOrHighBytes(w);
+
+				if (special == 0U)
+				{
+					i += sizeof(uint32_t);
+					continue;
+				}
+
+				i += firstFlagged(special);
+			}
+
 			if (buf[i] == '"')
 			{
 				ret = true;
@@ -1859,3 +1971,346 @@ JSONStatus_t JSON_Iterate(const char *buf,
 
 	return ret;
 }
+
+/** @cond DO_NOT_DOCUMENT */
+
+/**
+ * @brief Status for a value that failed to parse at an index.
+ *
+ * @param[in] i  The index at which parsing failed.
+ * @param[in] max  The size of the buffer.
+ *
+ * @return #JSONPartial if the buffer ended;
+ * #JSONIllegalDocument otherwise.
+ */
+static JSONStatus_t failedAt(size_t i, size_t max)
+{
+	return (i >= max) ? JSONPartial : JSONIllegalDocument;
+}
+
+/**
+ * @brief Match a key against the next part of each candidate query.
+ *
+ * @param[in] key  The key.
+ * @param[in] keyLength  The length of the key.
+ * @param[in] queries  The queries.
+ * @param[in] candidates  Bitmap of the queries which match the path so far.
+ * @param[in] prefixLength  The length of the path so far, including the
+ * trailing separator.
+ * @param[out] outComplete  Bitmap of queries which end with this key.
+ * @param[out] outPartial  Bitmap of queries which continue below this key.
+ */
+static void matchKey(const char        *key,
+                     size_t             keyLength,
+                     const JSONQuery_t *queries,
+                     uint32_t           candidates,
+                     size_t             prefixLength,
+                     uint32_t          *outComplete,
+                     uint32_t          *outPartial)
+{
+	size_t   i;
+	uint32_t bit;
+
+	*outComplete = 0U;
+	*outPartial  = 0U;
+
+	/* A key containing a separator can't match a single query part */
+	for (i = 0U; i < keyLength; i++)
+	{
+		if (isSeparator_(key[i]))
+		{
+			candidates = 0U;
+			break;
+		}
+	}
+
+	for (i = 0U; candidates != 0U; i++)
+	{
+		bit = 1U << i;
+
+		if ((candidates & bit) != 0U)
+		{
+			const JSONQuery_t *q   = &queries[i];
+			size_t             end = prefixLength + keyLength;
+
+			candidates &= ~bit;
+
+			if ((q->queryLength >= end) &&
+			    (strnEq(&q->query[prefixLength], key, keyLength) == true))
+			{
+				if (q->queryLength == end)
+				{
+					*outComplete |= bit;
+				}
+				else if (isSeparator_(q->query[end]))
+				{
+					*outPartial |= bit;
+				}
+				else
+				{
+					/* not a match */
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Record a value for each query which ends at it and has not
+ * already been found.
+ *
+ * @param[in] buf  The buffer being parsed.
+ * @param[in] value  The index of the value.
+ * @param[in] valueLength  The length of the value.
+ * @param[in,out] queries  The queries.
+ * @param[in] complete  Bitmap of the queries which end at this value.
+ */
+static void recordValue(const char  *buf,
+                        size_t       value,
+                        size_t       valueLength,
+                        JSONQuery_t *queries,
+                        uint32_t     complete)
+{
+	size_t      i;
+	uint32_t    bit;
+	JSONTypes_t t = getType(buf[value]);
+
+	if (t == JSONString)
+	{
+		/* strip the surrounding quotes */
+		value++;
+		valueLength -= 2U;
+	}
+
+	for (i = 0U; complete != 0U; i++)
+	{
+		bit = 1U << i;
+
+		if ((complete & bit) != 0U)
+		{
+			complete &= ~bit;
+
+			if (queries[i].value == NULL)
+			{
+				queries[i].value       = &buf[value];
+				queries[i].valueLength = valueLength;
+				queries[i].jsonType    = t;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Advance buffer index beyond an object, recording the values
+ * of any queries found in it.
+ *
+ * Only objects on the path to a query are walked here; any other
+ * collection is validated with skipCollection(), so the recursion is
+ * bounded by the depth of the queries.
+ *
+ * @param[in] buf  The buffer to parse.
+ * @param[in,out] start  The index of the opening brace.
+ * @param[in] max  The size of the buffer.
+ * @param[in,out] queries  The queries.
+ * @param[in] candidates  Bitmap of the queries which match the path so far.
+ * @param[in] prefixLength  The length of the path so far, including the
+ * trailing separator.
+ * @param[in] depth  The nesting depth of this object.
+ *
+ * @return #JSONSuccess if the object is valid JSON;
+ * otherwise as for JSON_Validate().
+ */
+static JSONStatus_t findInObject(const char  *buf,
+                                 size_t      *start,
+                                 size_t       max,
+                                 JSONQuery_t *queries,
+                                 uint32_t     candidates,
+                                 size_t       prefixLength,
+                                 int16_t      depth)
+{
+	JSONStatus_t ret = JSONSuccess;
+	size_t       i   = *start + 1U;
+	size_t       key, keyLength, value;
+	uint32_t     complete, partial;
+	bool         done = false;
+
+	coreJSON_ASSERT((buf != NULL) && (start != NULL) && (max > 0U));
+
+	skipSpace(buf, &i, max);
+
+	if ((i < max) && (buf[i] == '}'))
+	{
+		i++;
+		done = true;
+	}
+
+	while ((ret == JSONSuccess) && (done == false))
+	{
+		key = i;
+
+		if (skipString(buf, &i, max) != true)
+		{
+			ret = failedAt(i, max);
+			break;
+		}
+
+		keyLength = i - key - 2U;
+		key++;
+		skipSpace(buf, &i, max);
+
+		if ((i >= max) || (buf[i] != ':'))
+		{
+			ret = failedAt(i, max);
+			break;
+		}
+
+		i++;
+		skipSpace(buf, &i, max);
+		matchKey(&buf[key],
+		         keyLength,
+		         queries,
+		         candidates,
+		         prefixLength,
+		         &complete,
+		         &partial);
+		value = i;
+
+		if ((i < max) && (buf[i] == '{') && (partial != 0U))
+		{
+			ret = ((depth + 1) >= JSON_MAX_DEPTH)
+			        ? JSONMaxDepthExceeded
+			        : findInObject(buf,
+			                       &i,
+			                       max,
+			                       queries,
+			                       partial,
+			                       prefixLength + keyLength + 1U,
+			                       depth + 1);
+		}
+		else if ((i < max) && isOpenBracket_(buf[i]))
+		{
+			ret = skipCollection(buf, &i, max);
+		}
+		else if (skipAnyScalar(buf, &i, max) != true)
+		{
+			ret = failedAt(i, max);
+		}
+		else
+		{
+			/* scalar value */
+		}
+
+		if (ret != JSONSuccess)
+		{
+			break;
+		}
+
+		recordValue(buf, value, i - value, queries, complete);
+		skipSpace(buf, &i, max);
+
+		if ((i < max) && (buf[i] == ','))
+		{
+			i++;
+			skipSpace(buf, &i, max);
+		}
+		else if ((i < max) && (buf[i] == '}'))
+		{
+			i++;
+			done = true;
+		}
+		else
+		{
+			ret = failedAt(i, max);
+		}
+	}
+
+	if (ret == JSONSuccess)
+	{
+		*start = i;
+	}
+
+	return ret;
+}
+
+/** @endcond */
+
+/**
+ * See core_json.h for docs.
+ */
+JSONStatus_t JSON_ValidateAndFind(const char  *buf,
+                                  size_t       max,
+                                  JSONQuery_t *queries,
+                                  size_t       numQueries)
+{
+	JSONStatus_t ret = JSONSuccess;
+	size_t       i   = 0U;
+
+	if ((buf == NULL) || ((queries == NULL) && (numQueries > 0U)))
+	{
+		ret = JSONNullParameter;
+	}
+	else if ((max == 0U) || (numQueries > 32U))
+	{
+		ret = JSONBadParameter;
+	}
+	else
+	{
+		for (i = 0U; i < numQueries; i++)
+		{
+			if ((queries[i].query == NULL) || (queries[i].queryLength == 0U))
+			{
+				ret = JSONBadParameter;
+			}
+
+			queries[i].value       = NULL;
+			queries[i].valueLength = 0U;
+			queries[i].jsonType    = JSONInvalid;
+		}
+
+		i = 0U;
+	}
+
+	if (ret == JSONSuccess)
+	{
+		skipSpace(buf, &i, max);
+
+		if ((i < max) && (buf[i] == '{'))
+		{
+			ret = findInObject(buf,
+			                   &i,
+			                   max,
+			                   queries,
+			                   (numQueries == 32U) ? UINT32_MAX
+			                                       : ((1U << numQueries) - 1U),
+			                   0U,
+			                   0);
+		}
+		else
+		{
+/** @cond DO_NOT_DOCUMENT */
+#ifndef JSON_VALIDATE_COLLECTIONS_ONLY
+			if (skipAnyScalar(buf, &i, max) == true)
+			{
+				ret = JSONSuccess;
+			}
+			else
+#endif
+			/** @endcond */
+			{
+				ret = skipCollection(buf, &i, max);
+			}
+		}
+	}
+
+	if ((ret == JSONSuccess) && (i < max))
+	{
+		skipSpace(buf, &i, max);
+
+		if (i != max)
+		{
+			ret = JSONIllegalDocument;
+		}
+	}
+
+	return ret;
+}
@@ -367,6 +367,54 @@ extern "C"
 	                          JSONPair_t *outPair);
 /* @[declare_json_iterate] */
 
+	/**
+	 * @ingroup json_struct_types
+	 * @brief Structure to represent a key path to find and its value.
+	 */
+	typedef struct
+	{
+		const char *query;  /**< @brief Object keys separated by '.'. */
+		size_t queryLength; /**< @brief Length of the query. */
+		const char
+		  *value; /**< @brief Pointer to the value, or NULL if not found. */
+		size_t valueLength;   /**< @brief Length of the value. */
+		JSONTypes_t jsonType; /**< @brief JSON-specific type of the value. */
+	} JSONQuery_t;
+
+	/**
+	 * @brief Validate a JSON document and find the values of a set of key
+	 * paths in the same pass.
+	 *
+	 * This is equivalent to calling JSON_Validate() followed by
+	 * JSON_SearchConst() for each query, but walks the document once.  Each
+	 * query is a sequence of object keys separated by '.'; array indexes are
+	 * not supported.  As with JSON_SearchConst() string values are returned
+	 * without their quotes.  If a path occurs more than once the first value
+	 * is used, even if an earlier object on the path did not contain it.
+	 *
+	 * @param[in] buf  The buffer to parse.
+	 * @param[in] max  The size of the buffer.
+	 * @param[in,out] queries  The key paths to find, which receive the values.
+	 * @param[in] numQueries  The number of queries, at most 32.
+	 *
+	 * @note The values are only meaningful if #JSONSuccess is returned.  A
+	 * query which is not found in a valid document has a NULL value.
+	 *
+	 * @return #JSONSuccess if the buffer contents are valid JSON;
+	 * #JSONNullParameter if buf or queries is NULL;
+	 * #JSONBadParameter if max is 0, a query is empty, or there are more
+	 * than 32 queries;
+	 * #JSONIllegalDocument if the buffer contents are NOT valid JSON;
+	 * #JSONMaxDepthExceeded if object and array nesting exceeds a threshold;
+	 * #JSONPartial if the buffer contents are potentially valid but incomplete.
+	 */
+	/* @[declare_json_validateandfind] */
+	JSONStatus_t JSON_ValidateAndFind(const char  *buf,
+	                                  size_t       max,
+	                                  JSONQuery_t *queries,
+	                                  size_t       numQueries);
+/* @[declare_json_validateandfind] */
+
 /* *INDENT-OFF* */
 #ifdef __cplusplus
 }
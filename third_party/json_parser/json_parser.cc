@@ -17,6 +17,18 @@ namespace jsonParser
 		return JSON_Validate(buf, max);
 	}
 
+	/**
+	 * Validate that a string is serialised JSON and find the
+	 * values of a set of key paths in the same pass.
+	 */
+	JSONStatus_t __cheri_libcall validate_and_find(const char  *buf,
+	                                               size_t       max,
+	                                               JSONQuery_t *queries,
+	                                               size_t       numQueries)
+	{
+		return JSON_ValidateAndFind(buf, max, queries, numQueries);
+	}
+
 	/*
 	 * Set outValue to point to the start of a key (query) in
 	 * a JSON string (buf)
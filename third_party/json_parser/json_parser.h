@@ -14,6 +14,16 @@ namespace jsonParser
 	 */
 	JSONStatus_t __cheri_libcall validate(const char *buf, size_t max);
 
+	/**
+	 * Validate that a string is serialised JSON and find the
+	 * values of a set of key paths in the same pass.  Cheaper
+	 * than validate() followed by a search() for each key.
+	 */
+	JSONStatus_t __cheri_libcall validate_and_find(const char  *buf,
+	                                               size_t       max,
+	                                               JSONQuery_t *queries,
+	                                               size_t       numQueries);
+
 	/*
 	 * Set outValue to point to the start of a key (query) in
 	 * a JSON string (buf)
@@ -0,0 +1,71 @@
+// Copyright Configured Things and CHERIoT Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <algorithm>
+#include <debug.hh>
+#include <platform-entropy.hh>
+#include <thread.h>
+#include <tick_macros.h>
+
+/**
+ * Delay between attempts to connect to the MQTT broker.
+ *
+ * Each attempt doubles the limit on the delay, from BaseMs up to
+ * MaxMs, and the delay is chosen at random up to that limit, so a
+ * fleet of devices that lose their connection together (for
+ * example when the broker restarts) don't all reconnect together.
+ * The limit starts again from BaseMs once a connection has stayed
+ * up for StableMs.
+ *
+ * This is shared by the config Provider and the Hugh the Lightbulb
+ * devices.
+ */
+class ReconnectBackoff
+{
+	using Debug = ConditionalDebug<true, "Reconnect">;
+
+	static constexpr uint32_t BaseMs   = 500;
+	static constexpr uint32_t MaxMs    = 60 * 1000;
+	static constexpr uint32_t StableMs = 30 * 1000;
+
+	EntropySource entropy;
+	uint32_t      limitMs     = 0; // 0 for the first attempt
+	uint64_t      connectedAt = 0; // System tick of the last connect
+
+	static uint64_t now()
+	{
+		auto system_tick = thread_systemtick_get();
+		return (static_cast<uint64_t>(system_tick.hi) << 32) + system_tick.lo;
+	}
+
+	public:
+	/**
+	 * Wait before the next attempt to connect.
+	 */
+	void wait()
+	{
+		if ((connectedAt > 0) && (now() - connectedAt >= MS_TO_TICKS(StableMs)))
+		{
+			limitMs = 0;
+		}
+		connectedAt = 0;
+
+		if (limitMs > 0)
+		{
+			uint32_t delayMs = entropy() % (limitMs + 1);
+			Debug::log("Waiting {}ms before reconnecting", delayMs);
+			Timeout t{MS_TO_TICKS(delayMs)};
+			thread_sleep(&t);
+		}
+		limitMs = std::min(std::max(limitMs * 2, BaseMs), MaxMs);
+	}
+
+	/**
+	 * Note that a connection has been made.
+	 */
+	void connected()
+	{
+		connectedAt = now();
+	}
+};